@@ -3,6 +3,7 @@
 AR  ?= ar
 CC  ?= gcc
 CXX ?= g++
+OBJCOPY ?= objcopy
 
 # --------------------------------------------------------------
 # Fallback to Linux if no other OS defined
@@ -40,6 +41,11 @@ BASE_FLAGS += -DNDEBUG $(BASE_OPTS) -fvisibility=hidden
 CXXFLAGS   += -fvisibility-inlines-hidden
 endif
 
+ifeq ($(TRACE),true)
+# USDT probes, s. src/bollietrace.h
+BASE_FLAGS += -DBDL_TRACING
+endif
+
 BUILD_C_FLAGS   = $(BASE_FLAGS) -std=c99 -std=gnu99 $(CFLAGS) $(CPPFLAGS)
 BUILD_CXX_FLAGS = $(BASE_FLAGS) -std=c++11 $(CXXFLAGS) $(CPPFLAGS)
 
@@ -22,24 +22,29 @@
 * \author Bollie
 * \date 05 Nov 2016
 * \brief An LV2 tempo delay plugin with filters and tapping.
+*
+* This is the LV2 adapter, the delay itself lives in libbolliedelay.a, 
+* s. bolliedelay.h.
 */
 
+#include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
-#include <sys/time.h>
-#include "bolliefilter.h"
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "bolliedelay.h"
 
 #include "lv2/lv2plug.in/ns/lv2core/lv2.h"
+#include "lv2/lv2plug.in/ns/ext/atom/atom.h"
+#include "lv2/lv2plug.in/ns/ext/state/state.h"
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
 
-#define URI "https://ca9.eu/lv2/bolliedelay"
-
-#define MAX_TAPE_LEN 1920001
-
-
-/**
-* Make a bool type available. ;)
-*/
-typedef enum { false, true } bool;
+#define BDL_URI "https://ca9.eu/lv2/bolliedelay"
+#define TAPE_FILE "tape.raw"    ///< Name of the tape snapshot in the state
 
 
 /**
@@ -66,104 +71,99 @@ typedef enum {
     BDL_OUTPUT_L    = 17,
     BDL_OUTPUT_R    = 18,
     BDL_TEMPO_OUT   = 19,
+    BDL_QUALITY     = 20,
+    BDL_FREEZE      = 21,
 } PortIdx;
 
-typedef enum {
-    FADE_IN,
-    FADE_OUT,
-    FADE_OUT_DONE,
-    FILL_BUF,
-    CYCLE
-} BollieState;
-
 
 /**
-* Fade state
+* URIDs used for saving and restoring state
 */
 typedef struct {
-    int length;
-    int pos;
-} Fade;
+    LV2_URID atom_Double;   ///< atom:Double
+    LV2_URID atom_Float;    ///< atom:Float
+    LV2_URID atom_Int;      ///< atom:Int
+    LV2_URID atom_Path;     ///< atom:Path
+    LV2_URID rate;          ///< sample rate the delay lengths belong to
+    LV2_URID tempo_tap;     ///< tapped tempo
+    LV2_URID tempo;         ///< tempo the delay lengths were calculated for
+    LV2_URID div_l;         ///< division, left
+    LV2_URID div_r;         ///< division, right
+    LV2_URID quality;       ///< tape rate
+    LV2_URID d_samples_l;   ///< delay length in tape samples, left
+    LV2_URID d_samples_r;   ///< delay length in tape samples, right
+    LV2_URID tape;          ///< path of the tape snapshot
+} StateURIs;
 
 
 /**
-* Struct for THE BollieDelay instance, the host is going to use.
+* Struct for THE plugin instance, the host is going to use.
 */
 typedef struct {
-    const float* tempo_host;    ///< Tempo in BPM from host
-    const float* tempo_user;    ///< Tempo in BPM set by user
-    const float* tempo_mode;    ///< Tempo mode 0=host, 1=user
-    float* tempo_out;           ///< For displaying the current tempo on the UI
-    const float* tap;           ///< Control port for tapping
-    const float* mix;           ///< mix/blend in percentage
-    const float* feedback;      ///< feedback in percentage
-    const float* crossf;        ///< crossfeed in percentage between inputs
-    const float* low_on;        ///< LCF: 0=off, 1=on
-    const float* low_f;         ///< LCF cut off frequency
-    const float* low_q;         ///< LCF quality
-    const float* high_on;       ///< HCF: 0=off, 1=on
-    const float* high_f;        ///< HCF cuf off frequency
-    const float* high_q;        ///< HCF quality
-    const float* div_l;         ///< Divider enum "left"(0) input
-    const float* div_r;         ///< Divider enum "right"(1) input
+    const float* params[BD_N_PARAMS];   ///< control ports, s. BollieParam
     const float* input_l;       ///< input0, left side
     const float* input_r;       ///< input1, right side
     float* output_l;            ///< output1, left side
     float* output_r;            ///< output2, right side
+    float* tempo_out;           ///< For displaying the current tempo on the UI
+
+    BollieDelay* dsp;   ///< the delay engine
 
-    double rate;                ///< Current sample rate
-
-    float buffer_l[MAX_TAPE_LEN];   ///< delay buffer left
-    int buf_fill_l;                 ///< current fill level
-    float buffer_r[MAX_TAPE_LEN];   ///< delay buffer right
-    int buf_fill_r;                 ///< current fill level
-
-    BollieFilter filter_low_l;      ///< LCF left
-    BollieFilter filter_low_r;      ///< LCF right
-    BollieFilter filter_high_l;     ///< HCF left
-    BollieFilter filter_high_r;     ///< HCF right
-
-    int d_samples_l; /**< Storing the max. number of samples for the current 
-                            delay time, left */
-    int d_samples_r; /**< Storing the max. number of samples for the current 
-                            delay time, left */
-
-    Fade fade;          ///< Fade state
-    float tempo_tap;    ///< storing tapped tempo
-    float cur_tempo;    ///< state variable for current tempo set by tempo (above)
-    float cur_div_l;    ///< state var for current division, left side
-    float cur_div_r;    ///< state var for current division, right side
-    int wl_pos;         ///< current write position, left side
-    int wr_pos;         ///< current write position, right side
-    int rl_pos;         ///< current read position, left side
-    int rr_pos;         ///< current read position, right side
-    int start_tap;      ///< when did the last tap happen (ms since epoch)
-    float dry_gain;     ///< current state leading towards target dry gain
-    float wet_gain;     ///< current state leading towards target wet gain
-    float cur_feedback; ///< current state leading towards target feedback gain
-    float cur_crossf;   ///< current state leading towards target crossfeed gain
-
-    BollieState state;  ///< Overall state
-} BollieDelay;
+    LV2_URID_Map* map;  ///< URID map feature, NULL if the host has none
+    StateURIs uris;     ///< mapped URIs for the state interface
+} BollieLV2;
+
+
+/**
+* Looks up a feature passed by the host.
+* \param features NULL terminated feature list, may be NULL itself
+* \param uri      URI of the feature
+* \return the feature's data or NULL if not present
+*/
+static void* get_feature(const LV2_Feature* const* features, const char* uri) {
+    for (int i = 0 ; features && features[i] ; ++i) {
+        if (strcmp(features[i]->URI, uri) == 0)
+            return features[i]->data;
+    }
+    return NULL;
+}
 
 
 /**
 * Instantiates the plugin
-* Allocates memory for the BollieDelay object and returns a pointer as
-* LV2Handle.
+* Allocates memory for the BollieLV2 object and the delay engine and 
+* returns a pointer as LV2Handle.
 */
 static LV2_Handle instantiate(const LV2_Descriptor * descriptor, double rate,
     const char* bundle_path, const LV2_Feature* const* features) {
     
-    BollieDelay *self = (BollieDelay*)calloc(1, sizeof(BollieDelay));
-
-    // Memorize sample rate for calculation
-    self->rate = rate;
-
-    // Fade in set for first delay
-    self->fade.length = ceil(rate / 50);
-    //self->fade.length = ceil(rate *4); // just for debugging
-    self->fade.pos = 0;
+    BollieLV2* self = (BollieLV2*)calloc(1, sizeof(BollieLV2));
+    void* mem = malloc(bd_size());
+    if (!self || !mem) {
+        free(self);
+        free(mem);
+        return NULL;
+    }
+    self->dsp = bd_create(mem, rate);
+
+    // Map the URIs needed for the state interface
+    self->map = get_feature(features, LV2_URID__map);
+    if (self->map) {
+        LV2_URID_Map* m = self->map;
+        self->uris.atom_Double = m->map(m->handle, LV2_ATOM__Double);
+        self->uris.atom_Float = m->map(m->handle, LV2_ATOM__Float);
+        self->uris.atom_Int = m->map(m->handle, LV2_ATOM__Int);
+        self->uris.atom_Path = m->map(m->handle, LV2_ATOM__Path);
+        self->uris.rate = m->map(m->handle, BDL_URI "#rate");
+        self->uris.tempo_tap = m->map(m->handle, BDL_URI "#tempo_tap");
+        self->uris.tempo = m->map(m->handle, BDL_URI "#tempo");
+        self->uris.div_l = m->map(m->handle, BDL_URI "#div_l");
+        self->uris.div_r = m->map(m->handle, BDL_URI "#div_r");
+        self->uris.quality = m->map(m->handle, BDL_URI "#quality");
+        self->uris.d_samples_l = m->map(m->handle, BDL_URI "#d_samples_l");
+        self->uris.d_samples_r = m->map(m->handle, BDL_URI "#d_samples_r");
+        self->uris.tape = m->map(m->handle, BDL_URI "#tape");
+    }
 
     return (LV2_Handle)self;
 }
@@ -171,58 +171,58 @@ static LV2_Handle instantiate(const LV2_Descriptor * descriptor, double rate,
 
 /**
 * Used by the host to connect the ports of this plugin.
-* \param instance current LV2_Handle (will be cast to BollieDelay*)
+* \param instance current LV2_Handle (will be cast to BollieLV2*)
 * \param port LV2 port index, maches the enum above.
 * \param data Pointer to the actual port data.
 */
 static void connect_port(LV2_Handle instance, uint32_t port, void *data) {
-    BollieDelay *self = (BollieDelay*)instance;
+    BollieLV2* self = (BollieLV2*)instance;
 
     switch ((PortIdx)port) {
         case BDL_TEMPO_HOST:
-            self->tempo_host = data;
+            self->params[BD_TEMPO_HOST] = data;
             break;
         case BDL_TEMPO_USER:
-            self->tempo_user = data;
+            self->params[BD_TEMPO_USER] = data;
             break;
         case BDL_TEMPO_MODE:
-            self->tempo_mode = data;
+            self->params[BD_TEMPO_MODE] = data;
             break;
         case BDL_TAP:
-            self->tap = data;
+            self->params[BD_TAP] = data;
             break;
         case BDL_MIX:
-            self->mix = data;
+            self->params[BD_MIX] = data;
             break;
         case BDL_FEEDBACK:
-            self->feedback = data;
+            self->params[BD_FEEDBACK] = data;
             break;
         case BDL_CROSSF:
-            self->crossf = data;
+            self->params[BD_CROSSF] = data;
             break;
         case BDL_LOW_ON:
-            self->low_on = data;
+            self->params[BD_LOW_ON] = data;
             break;
         case BDL_LOW_F:
-            self->low_f = data;
+            self->params[BD_LOW_F] = data;
             break;
         case BDL_LOW_Q:
-            self->low_q = data;
+            self->params[BD_LOW_Q] = data;
             break;
         case BDL_HIGH_ON:
-            self->high_on = data;
+            self->params[BD_HIGH_ON] = data;
             break;
         case BDL_HIGH_F:
-            self->high_f = data;
+            self->params[BD_HIGH_F] = data;
             break;
         case BDL_HIGH_Q:
-            self->high_q = data;
+            self->params[BD_HIGH_Q] = data;
             break;
         case BDL_DIV_L:
-            self->div_l = data;
+            self->params[BD_DIV_L] = data;
             break;
         case BDL_DIV_R:
-            self->div_r = data;
+            self->params[BD_DIV_R] = data;
             break;
         case BDL_INPUT_L:
             self->input_l = data;
@@ -239,415 +239,320 @@ static void connect_port(LV2_Handle instance, uint32_t port, void *data) {
         case BDL_TEMPO_OUT:
             self->tempo_out = data;
             break;
+        case BDL_QUALITY:
+            self->params[BD_QUALITY] = data;
+            break;
+        case BDL_FREEZE:
+            self->params[BD_FREEZE] = data;
+            break;
     }
 }
-    
+
 
 /**
 * This has to reset all the internal states of the plugin
 * \param instance pointer to current plugin instance
 */
 static void activate(LV2_Handle instance) {
-    BollieDelay* self = (BollieDelay*)instance;
-    // Let's remove all that noise
-    for (int i = 0 ; i < MAX_TAPE_LEN ; ++i) {
-        self->buffer_l[i] = 0;
-        self->buffer_r[i] = 0;
-    }
-    self->state = FILL_BUF;
-
-    self->buf_fill_r = 0;
-    self->buf_fill_l = 0;
-
-    // Initialize number of samples needed
-    self->d_samples_l = 0;
-    self->d_samples_r = 0;
-
-    // Clear the filters
-    bf_reset(&self->filter_low_l);
-    bf_reset(&self->filter_low_r);
-    bf_reset(&self->filter_high_l);
-    bf_reset(&self->filter_high_r);
-
-    // Reset the positions & state variables
-    self->wl_pos = 0;
-    self->wr_pos = 0;
-    self->rl_pos = 0;
-    self->rr_pos = 0;
-    self->cur_tempo = 0;
-    self->cur_div_l = 0;
-    self->cur_div_r = 0;
-    self->dry_gain = 0;
-    self->wet_gain = 0;
-
-    // Reset tapping
-    self->start_tap = 0;
-    self->tempo_tap = 120;
+    BollieLV2* self = (BollieLV2*)instance;
+    bd_reset(self->dsp);
 }
 
 
 /**
-* Handles a tap on the tap button and calculates time differences
-* \param self pointer to current plugin instance
-* \return Beats per minute or zero if it didn't work
+* Main process function of the plugin.
+* \param instance  handle of the current plugin
+* \param n_samples number of samples in this current input block.
 */
-static float handle_tap(BollieDelay* self) {
-
-    float d = 0;
-
-    struct timeval t_cur;
-    gettimeofday(&t_cur, 0);
+static void run(LV2_Handle instance, uint32_t n_samples) {
+    BollieLV2* self = (BollieLV2*)instance;
 
-    // convert it to milliseconds
-    long int t_cur_ms = floor(t_cur.tv_sec * 1000 + t_cur.tv_usec / 1000);
+    // Control ports are read once per block
+    for (int i = 0 ; i < BD_N_PARAMS ; ++i)
+        bd_set_param(self->dsp, (BollieParam)i, *self->params[i]);
 
-    // If start tap is memorized, do some calculations
-    if (self->start_tap) {
-        d = t_cur_ms - self->start_tap;
+    bd_process(self->dsp, self->input_l, self->input_r, self->output_l,
+        self->output_r, n_samples);
 
-        // Reset if we exceed the maximum delay time
-        if (d <= 50 || d > 10000 ) {
-            d = 0;
-        }
-    }
-    self->start_tap = t_cur_ms;
-    return (d > 0 ? 60000 / d : 0);   // convert to bpm
+    // Send current tempo to control port
+    const float tempo = bd_get_tempo(self->dsp);
+    if (tempo > 0)
+        *self->tempo_out = tempo;
 }
 
 
 /**
-* Calculates number of samples used for divided delay times.
-* \param self pointer to current plugin instance.
-* \param tempo Tempo in BPM
-* \param div   Divider
-* \return number of samples needed for the delay buffer
-* \todo divider enum
+* Called, when the host deactivates the plugin.
 */
-static int calc_delay_samples(BollieDelay* self, float tempo, int div) {
-    // Calculate the samples needed 
-    float d = 60 / tempo * self->rate;
-    switch(div) {
-        case 1:
-        d = d * 2/3;
-            break;
-        case 2:
-        d = d / 2;
-            break;
-        case 3:
-        d = d / 4 * 3;
-            break;
-        case 4:
-        d = d / 3;
-            break;
-        case 5:
-            d = d / 4;
-            break;
-    }
-    return floor(d);
+static void deactivate(LV2_Handle instance) {
 }
 
 
 /**
-* Main process function of the plugin.
-* \param instance  handle of the current plugin
-* \param n_samples number of samples in this current input block.
+* Cleanup, freeing memory and stuff
 */
-static void run(LV2_Handle instance, uint32_t n_samples) {
-    BollieDelay* self = (BollieDelay*)instance;
+static void cleanup(LV2_Handle instance) {
+    BollieLV2* self = (BollieLV2*)instance;
+    free(self->dsp);
+    free(self);
+}
 
-    // Get the fade status object
-    Fade* f = &self->fade;
-    BollieState state = self->state;
 
-    // First some TAP handling
-    if (*(self->tap) > 0) {
-        float d = handle_tap(self);
-        if (d > 0) 
-            self->tempo_tap = (float)d;
-    }
+/**
+* Frees a path handed out by the host's mapPath or makePath feature.
+* \param features features passed to save() or restore()
+* \param path     path to free
+*/
+static void free_state_path(const LV2_Feature* const* features, char* path) {
+    LV2_State_Free_Path* free_path = get_feature(features, 
+        LV2_STATE__freePath);
+    if (free_path)
+        free_path->free_path(free_path->handle, path);
+    else
+        free(path);
+}
 
-    // Handle tempo mode
-    float tempo = *self->tempo_host; 
-    switch ((int)(*self->tempo_mode)) {
-        case 1:
-            tempo = *self->tempo_user;
-            break;
-        case 2:
-            tempo = self->tempo_tap;
-            break;
-    }
 
-    // Tempo changes always initiate a fade out.
-    if ((tempo != self->cur_tempo ||
-        *self->div_l != self->cur_div_l ||
-        *self->div_r != self->cur_div_r)
-    ) {
-        // If the fade out is done, resize buffer and get everything set for 
-        // filling the buffers.
-        if (state == FADE_OUT_DONE) {
-            // Memorize the user's current settings.
-            self->cur_tempo = tempo;
-            self->cur_div_l = *self->div_l;
-            self->cur_div_r = *self->div_r;
-
-            // Calculate the samples needed for the currently set delay time
-            self->d_samples_l = 
-                calc_delay_samples(self, tempo, *self->div_l);
-            self->d_samples_r =
-                calc_delay_samples(self, tempo, *self->div_r);
-
-            /* The buffer always needs to be one sample bigger than the delay 
-            time.  In order to not exceed MAX_TAPE_LEN, cut the number of 
-            samples, if needed */
-            if (self->d_samples_l+1 > MAX_TAPE_LEN)
-                self->d_samples_l = MAX_TAPE_LEN-1;
-
-            if (self->d_samples_r+1 > MAX_TAPE_LEN)
-                self->d_samples_r = MAX_TAPE_LEN-1;
-
-            // Reset positions and pretend the buffer to be empty
-            self->rl_pos = 0;
-            self->rr_pos = 0;
-            self->wl_pos = self->d_samples_l;
-            self->wr_pos = self->d_samples_r;
-            self->buf_fill_l = 0;
-            self->buf_fill_r = 0;
-
-            // Send current tempo to control port
-            *self->tempo_out = tempo;
-
-            // Ready to fill buffer
-            state = FILL_BUF;
-        }
-        else if (state != FADE_OUT) {
-             // If we reach this, tempo has been changed, but no fade out
-             // has been done yet.
-             state = FADE_OUT;
-        }
+/**
+* Writes the last n frames of the tape in playing order to a raw file of
+* interleaved floats in the state directory and stores its path.
+* \param self     pointer to current plugin instance
+* \param store    host's store function
+* \param handle   host's state handle
+* \param features features passed to save()
+* \param n        number of frames to write
+* \return LV2_STATE_SUCCESS or an error
+*/
+static LV2_State_Status save_tape(BollieLV2* self, 
+    LV2_State_Store_Function store, LV2_State_Handle handle,
+    const LV2_Feature* const* features, int n) {
+
+    LV2_State_Make_Path* make_path = get_feature(features, 
+        LV2_STATE__makePath);
+    LV2_State_Map_Path* map_path = get_feature(features, LV2_STATE__mapPath);
+    if (!make_path || !map_path)
+        return LV2_STATE_ERR_NO_FEATURE;
+
+    char* path = make_path->path(make_path->handle, TAPE_FILE);
+    if (!path)
+        return LV2_STATE_ERR_UNKNOWN;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        free_state_path(features, path);
+        return LV2_STATE_ERR_UNKNOWN;
     }
 
-    // Let's do the vfade gain calculation
-    const float cp_blend = *self->mix;
-    float target_dry_gain = 1;
-    float target_wet_gain = 0;
-    if (cp_blend > 0 && cp_blend < 50) {
-        target_wet_gain = powf(10.0f, (cp_blend-50) * 0.04f);
-    }
-    else if (cp_blend < 100 && cp_blend > 50) {
-        target_wet_gain = 1;
-        target_dry_gain = powf(10.0f, (cp_blend-50) * -0.04f);
-    }
-    else if (cp_blend == 50) {
-        target_wet_gain = 1;
-    }
-    else if (cp_blend == 100) {
-        target_wet_gain = 1;
-        target_dry_gain = 0;
+    // Safe while the plugin is running, s. bd_tape_spans()
+    BollieSpan spans[2];
+    bd_tape_spans(self->dsp, n, spans);
+    size_t written = 0;
+    for (int i = 0 ; i < 2 ; ++i)
+        written += fwrite(spans[i].frames, 2 * sizeof(float), spans[i].n, f);
+    const int ok = (fclose(f) == 0 && written == (size_t)n);
+
+    LV2_State_Status status = LV2_STATE_ERR_UNKNOWN;
+    char* apath = ok ? map_path->abstract_path(map_path->handle, path) : NULL;
+    if (apath) {
+        status = store(handle, self->uris.tape, apath, strlen(apath) + 1,
+            self->uris.atom_Path, LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE);
+        free_state_path(features, apath);
     }
+    free_state_path(features, path);
+    return status;
+}
 
-    // Lets do the feedback/crossfeed calculation        
-    const float cp_feedback = *self->feedback;
-    float target_feedback = 0;
-    if (cp_feedback > 0 && cp_feedback < 100) {
-        target_feedback = powf(10.0f, (cp_feedback-100) * 0.02f);
-    }
-    else if (cp_feedback == 100) {
-        target_feedback = 1;
-    }
 
-    const float cp_crossf = *self->crossf;
-    float target_crossf = 0;
-    if (cp_crossf > 0 && cp_crossf < 100) {
-        target_crossf = powf(10.0f, (cp_crossf-100) * 0.02f);
+/**
+* Maps a tape snapshot written by save_tape(). Mapping instead of reading
+* keeps this at a few milliseconds even for the longest delay.
+* \param path  absolute path of the snapshot
+* \param bytes expected size of the snapshot
+* \return the snapshot, NULL if it doesn't exist or has the wrong size
+*/
+static const float* map_tape(const char* path, size_t bytes) {
+#ifdef _WIN32
+    float* data = malloc(bytes);
+    FILE* f = fopen(path, "rb");
+    if (!data || !f || fread(data, 1, bytes, f) != bytes || fgetc(f) != EOF) {
+        free(data);
+        data = NULL;
     }
-    else if (cp_feedback == 100) {
-        target_crossf = 1;
+    if (f)
+        fclose(f);
+    return data;
+#else
+    const float* data = NULL;
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size == bytes) {
+        int mflags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        mflags |= MAP_POPULATE;
+#endif
+        void* m = mmap(NULL, bytes, PROT_READ, mflags, fd, 0);
+        if (m != MAP_FAILED)
+            data = m;
     }
+    if (fd >= 0)
+        close(fd);
+    return data;
+#endif
+}
 
-    // State stuff to get more from heap to stack
-    float dry_gain = self->dry_gain;
-    float wet_gain = self->wet_gain;
-    float cur_feedback = self->cur_feedback;
-    float cur_crossf = self->cur_crossf;
-    int buf_fill_l = self->buf_fill_l;
-    int buf_fill_r = self->buf_fill_r;
-    int d_samples_l = self->d_samples_l;
-    int d_samples_r = self->d_samples_r;
-    int rl_pos = self->rl_pos;
-    int rr_pos = self->rr_pos;
-    int wl_pos = self->wl_pos;
-    int wr_pos = self->wr_pos;
-    float fc = 0; // fade coefficient
-
-    // Loop over the block of audio we got
-    for (unsigned int i = 0 ; i < n_samples ; ++i) {
-
-        // Current samples
-        float cur_fs_l = self->input_l[i];
-        float cur_fs_r = self->input_r[i];
-
-        // Previous samples
-        float old_s_l = 0;
-        float old_s_r = 0;
-
-        // Calculates the fade coeff. This also increases
-        // the internal fade position.
-        switch (state) {
-            case FADE_OUT:
-                if (f->pos > 0) {
-                    fc = --f->pos * (1/(float)f->length);
-                }
-                else {
-                    fc = 0;
-                    state = FADE_OUT_DONE;
-                }
-                break;
-            case FADE_OUT_DONE:
-                fc = 0; // keep it at zero
-                break;
-            case FILL_BUF:
-                // If the buffer is filled, initiate a fade in
-                if (buf_fill_r == d_samples_r &&
-                    buf_fill_l == d_samples_l
-                ) {
-                    state = FADE_IN;
-                }
-                fc = 0;
-                break;
-            case FADE_IN:   
-                if (f->pos < f->length) {
-                    fc = f->pos++ * (1/(float)f->length);
-                }
-                else {
-                    state = CYCLE;
-                    fc = 1;
-                }
-                break;
-            case CYCLE: 
-                fc = 1;
-            default:
-                fc = 1;
-                break;
-        }
-
-        // In these state retrieve old samples from delay buffer
-        if (state == FADE_IN || state == FADE_OUT || state == CYCLE) {
-                old_s_l = self->buffer_l[rl_pos] * fc;
-                old_s_r = self->buffer_r[rr_pos] * fc;
-        }
-    
-        // Apply the low cut filter if enabled
-        if (*self->low_on) {
-            cur_fs_l = bf_lcf(
-                cur_fs_l, 
-                *self->low_f, 
-                *self->low_q, 
-                self->rate, 
-                &self->filter_low_l
-            );
-            cur_fs_r = bf_lcf(
-                cur_fs_r, 
-                *self->low_f, 
-                *self->low_q, 
-                self->rate, 
-                &self->filter_low_r
-            );
-        }
- 
-        // Apply the high cut filter if enabled
-        if (*self->high_on) {
-            cur_fs_l = bf_hcf(
-                cur_fs_l, 
-                *self->high_f, 
-                *self->high_q, 
-                self->rate, 
-                &self->filter_high_l
-            );
-            cur_fs_r = bf_hcf(
-                cur_fs_r,
-                *self->high_f,
-                *self->high_q,
-                self->rate, 
-                &self->filter_high_r
-            );
-        }
- 
-
-        /* Feedback and Crossfeed filling the buffer */
-
-        // parameter smoothing for feedback/crossfeed
-        cur_feedback = target_feedback * 0.01f + cur_feedback * 0.99f;
-        cur_crossf = target_crossf * 0.01f + cur_crossf * 0.99f;
-
-        // Left Channel
-        self->buffer_l[wl_pos] = cur_fs_l       // current filtered sample
-            + old_s_r * cur_crossf              // crossfeed sample
-            + old_s_l * cur_feedback            // feedback sample
-        ;
-
-        // Right channel (s. above)
-        self->buffer_r[wr_pos] = cur_fs_r
-            + old_s_l * cur_crossf
-            + old_s_r * cur_feedback
-        ;
-
-        // Increase buf fill count
-        if (buf_fill_l < d_samples_l)
-            buf_fill_l++;
-
-        if (buf_fill_r < d_samples_r)
-            buf_fill_r++;
-
-        /* end of buffer handling */
-
-        // Paraemter smoothing for wet and dry gain
-        wet_gain = target_wet_gain * 0.01f + wet_gain * 0.99f;
-        dry_gain = target_dry_gain * 0.01f + dry_gain * 0.99f;
-
-        // Will it blend? ;)
-        self->output_l[i] = 
-            dry_gain * self->input_l[i] + wet_gain * old_s_l;
-        self->output_r[i] = 
-            dry_gain * self->input_r[i] + wet_gain * old_s_r;
 
-        // Iterate write position, reset to 0 if required
-        wl_pos = (wl_pos+1 >= d_samples_l+1 ? 0 : wl_pos+1);
-        wr_pos = (wr_pos+1 >= d_samples_r+1 ? 0 : wr_pos+1);
+/**
+* Releases a snapshot returned by map_tape().
+* \param data  the snapshot
+* \param bytes its size
+*/
+static void unmap_tape(const float* data, size_t bytes) {
+#ifdef _WIN32
+    free((void*)data);
+#else
+    munmap((void*)data, bytes);
+#endif
+}
 
-        // Iterate reade positions, reset to 0 if required.
-        rl_pos = (rl_pos+1 >= d_samples_l+1 ? 0 : rl_pos+1);
-        rr_pos = (rr_pos+1 >= d_samples_r+1 ? 0 : rr_pos+1);
 
-    }
-    // Memorize state for next run
-    self->state = state;
-    self->buf_fill_l = buf_fill_l;
-    self->buf_fill_r = buf_fill_r;
-    self->d_samples_l = d_samples_l;
-    self->d_samples_r = d_samples_r;
-    self->rl_pos = rl_pos;
-    self->rr_pos = rr_pos;
-    self->wl_pos = wl_pos;
-    self->wr_pos = wr_pos;
-    self->wet_gain = wet_gain;
-    self->dry_gain = dry_gain;
-    self->cur_crossf = cur_crossf;
-    self->cur_feedback = cur_feedback;
+/**
+* Saves the tapped tempo and, while the tape is cycling, the delay lengths
+* and the tape contents. May be called concurrently with run().
+* \param instance current LV2_Handle (will be cast to BollieLV2*)
+* \param store    host's store function
+* \param handle   host's state handle
+* \param flags    LV2_State_Flags
+* \param features features like mapPath and makePath
+* \return LV2_STATE_SUCCESS or an error
+*/
+static LV2_State_Status save(LV2_Handle instance,
+    LV2_State_Store_Function store, LV2_State_Handle handle, uint32_t flags,
+    const LV2_Feature* const* features) {
+
+    BollieLV2* self = (BollieLV2*)instance;
+    if (!self->map)
+        return LV2_STATE_ERR_NO_FEATURE;
+
+    BollieRecall r;
+    const int n = bd_get_recall(self->dsp, &r);
+
+    const StateURIs* u = &self->uris;
+    const uint32_t pod = LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE;
+    store(handle, u->tempo_tap, &r.tempo_tap, sizeof(float), u->atom_Float,
+        pod);
+
+    // Anything else would be recalculated and refilled anyway
+    if (n == 0)
+        return LV2_STATE_SUCCESS;
+
+    store(handle, u->rate, &r.rate, sizeof(double), u->atom_Double, pod);
+    store(handle, u->tempo, &r.tempo, sizeof(float), u->atom_Float, pod);
+    store(handle, u->div_l, &r.div_l, sizeof(float), u->atom_Float, pod);
+    store(handle, u->div_r, &r.div_r, sizeof(float), u->atom_Float, pod);
+    store(handle, u->quality, &r.quality, sizeof(float), u->atom_Float, pod);
+    store(handle, u->d_samples_l, &r.d_samples_l, sizeof(int32_t), 
+        u->atom_Int, pod);
+    store(handle, u->d_samples_r, &r.d_samples_r, sizeof(int32_t), 
+        u->atom_Int, pod);
+
+    // The tape is optional, hosts without makePath/mapPath don't get it
+    save_tape(self, store, handle, features, n);
+    return LV2_STATE_SUCCESS;
 }
 
 
 /**
-* Called, when the host deactivates the plugin.
+* Retrieves a value of a fixed size from the host's state.
+* \param retrieve host's retrieve function
+* \param handle   host's state handle
+* \param key      URID of the value
+* \param type     expected type
+* \param size     expected size
+* \param value    filled with the value, if it is present
+* \return 1 if the value was found with the expected type and size
 */
-static void deactivate(LV2_Handle instance) {
+static int retrieve_value(LV2_State_Retrieve_Function retrieve,
+    LV2_State_Handle handle, LV2_URID key, LV2_URID type, size_t size,
+    void* value) {
+
+    size_t s;
+    uint32_t t, f;
+    const void* v = retrieve(handle, key, &s, &t, &f);
+    if (!v || t != type || s != size)
+        return 0;
+    memcpy(value, v, size);
+    return 1;
 }
 
 
 /**
-* Cleanup, freeing memory and stuff
+* Restores what save() stored, s. bd_restore(). Hosts don't call this 
+* concurrently with run(), the next run() continues from the restored state
+* without recalculating anything.
+* \param instance current LV2_Handle (will be cast to BollieLV2*)
+* \param retrieve host's retrieve function
+* \param handle   host's state handle
+* \param flags    LV2_State_Flags
+* \param features features like mapPath
+* \return LV2_STATE_SUCCESS or an error
 */
-static void cleanup(LV2_Handle instance) {
-    free(instance);
+static LV2_State_Status restore(LV2_Handle instance,
+    LV2_State_Retrieve_Function retrieve, LV2_State_Handle handle,
+    uint32_t flags, const LV2_Feature* const* features) {
+
+    BollieLV2* self = (BollieLV2*)instance;
+    if (!self->map)
+        return LV2_STATE_ERR_NO_FEATURE;
+
+    // Whatever is missing stays as it is
+    BollieRecall r;
+    bd_get_recall(self->dsp, &r);
+
+    const StateURIs* u = &self->uris;
+    retrieve_value(retrieve, handle, u->tempo_tap, u->atom_Float, 
+        sizeof(float), &r.tempo_tap);
+
+    // Without the complete set, only the tapped tempo is restored
+    const int complete = 
+        retrieve_value(retrieve, handle, u->rate, u->atom_Double, 
+            sizeof(double), &r.rate) &&
+        retrieve_value(retrieve, handle, u->tempo, u->atom_Float,
+            sizeof(float), &r.tempo) &&
+        retrieve_value(retrieve, handle, u->div_l, u->atom_Float,
+            sizeof(float), &r.div_l) &&
+        retrieve_value(retrieve, handle, u->div_r, u->atom_Float,
+            sizeof(float), &r.div_r) &&
+        retrieve_value(retrieve, handle, u->quality, u->atom_Float,
+            sizeof(float), &r.quality) &&
+        retrieve_value(retrieve, handle, u->d_samples_l, u->atom_Int,
+            sizeof(int32_t), &r.d_samples_l) &&
+        retrieve_value(retrieve, handle, u->d_samples_r, u->atom_Int,
+            sizeof(int32_t), &r.d_samples_r);
+    if (!complete)
+        r.rate = 0;
+
+    // The tape snapshot, if there is one
+    const int n = (r.d_samples_l > r.d_samples_r ? 
+        r.d_samples_l : r.d_samples_r);
+    const size_t bytes = (n > 0 ? n : 0) * 2 * sizeof(float);
+    const float* tape = NULL;
+
+    LV2_State_Map_Path* map_path = get_feature(features, LV2_STATE__mapPath);
+    size_t size;
+    uint32_t type, tflags;
+    const char* apath = retrieve(handle, u->tape, &size, &type, &tflags);
+    if (complete && bytes > 0 && map_path && apath && type == u->atom_Path) {
+        char* path = map_path->absolute_path(map_path->handle, apath);
+        if (path) {
+            tape = map_tape(path, bytes);
+            free_state_path(features, path);
+        }
+    }
+
+    bd_restore(self->dsp, &r, tape, (tape ? n : 0));
+    if (tape)
+        unmap_tape(tape, bytes);
+    return LV2_STATE_SUCCESS;
 }
 
 
@@ -655,6 +560,9 @@ static void cleanup(LV2_Handle instance) {
 * extension stuff for additional interfaces
 */
 static const void* extension_data(const char* uri) {
+    static const LV2_State_Interface state = { save, restore };
+    if (strcmp(uri, LV2_STATE__interface) == 0)
+        return &state;
     return NULL;
 }
 
@@ -663,7 +571,7 @@ static const void* extension_data(const char* uri) {
 * Descriptor linking our methods.
 */
 static const LV2_Descriptor descriptor = {
-    URI,
+    BDL_URI,
     instantiate,
     connect_port,
     activate,
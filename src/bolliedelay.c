@@ -0,0 +1,1437 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file bolliedelay.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief The delay engine: tape, state machine, gain laws and filters.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "bolliedelay.h"
+#include "bolliefilter.h"
+#include "halfband.h"
+#include "bollietrace.h"
+
+#define MAX_TAPE_LEN 1920001
+#define TAPE_BITS 21            ///< 2^TAPE_BITS frames hold MAX_TAPE_LEN
+#define TAPE_FRAMES (1 << TAPE_BITS)
+#define TAPE_MASK (TAPE_FRAMES - 1)
+#define BDL_CHUNK 256           ///< Frames processed per filter/tape pass
+#define ECO_MAX_STAGES 2        ///< Halfband stages for quarter rate
+#define MONO_RESIDUAL 1e-5f     ///< Max. difference of the tapes for mono
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BDL_X86_DISPATCH    ///< Runtime selection of AVX2/AVX-512 kernels
+#endif
+
+
+/**
+* Make a bool type available. ;)
+*/
+typedef enum { false, true } bool;
+
+typedef enum {
+    FADE_IN,
+    FADE_OUT,
+    FADE_OUT_DONE,
+    FILL_BUF,
+    CYCLE
+} BollieState;
+
+/**
+* Freeze state, s. bd_process()
+*/
+typedef enum {
+    FREEZE_OFF,     ///< the tape runs as usual
+    FREEZE_IN,      ///< writes crossfade into copies of the repeats
+    FROZEN,         ///< the tape is only read, looping the last delay time
+    FREEZE_OUT      ///< the repeats carry on from the loop, s. thaw_frame()
+} FreezeState;
+
+
+/**
+* Fade state
+*/
+typedef struct {
+    int length;
+    int pos;
+} Fade;
+
+
+/**
+* Target gains for the current block
+*/
+typedef struct {
+    float dry_gain;     ///< target dry gain
+    float wet_gain;     ///< target wet gain
+    float feedback;     ///< target feedback gain
+    float crossf;       ///< target crossfeed gain
+} GainTargets;
+
+/**
+* Block processing kernel, s. process_frames()
+*/
+typedef void (*ProcessFunc)(BollieDelay* self, const GainTargets* t,
+    uint32_t n_samples);
+
+
+/**
+* Struct for THE BollieDelay instance.
+*/
+struct BollieDelay {
+    float params[BD_N_PARAMS];  ///< parameters, s. bd_set_param()
+    const float* input_l;       ///< input of the current block, left side
+    const float* input_r;       ///< input of the current block, right side
+    float* output_l;            ///< output of the current block, left side
+    float* output_r;            ///< output of the current block, right side
+
+    double rate;                ///< Current sample rate
+
+    float tape[TAPE_FRAMES][2];     ///< delay ring, interleaved l/r frames
+    int tape_mask;                  ///< ring size - 1, eco uses its start
+    int buf_fill;                   ///< current fill level
+
+    BollieFilter filter_low_l;      ///< LCF left
+    BollieFilter filter_low_r;      ///< LCF right
+    BollieFilter filter_high_l;     ///< HCF left
+    BollieFilter filter_high_r;     ///< HCF right
+
+    int d_samples_l; /**< Storing the max. number of samples for the current 
+                            delay time, left */
+    int d_samples_r; /**< Storing the max. number of samples for the current 
+                            delay time, left */
+
+    Fade fade;          ///< Fade state
+    float tempo_tap;    ///< storing tapped tempo
+    float cur_tempo;    ///< state variable for current tempo set by tempo (above)
+    float cur_div_l;    ///< state var for current division, left side
+    float cur_div_r;    ///< state var for current division, right side
+    int w_pos;          ///< write position, reads follow d_samples_* behind
+    long since_tap;     ///< samples since the last tap, -1 if none
+    float dry_gain;     ///< current state leading towards target dry gain
+    float wet_gain;     ///< current state leading towards target wet gain
+    float cur_feedback; ///< current state leading towards target feedback gain
+    float cur_crossf;   ///< current state leading towards target crossfeed gain
+    float cur_quality;  ///< state var for current quality
+
+    int eco_stages;     ///< halfband stages in use, 0 = tape at full rate
+    Halfband decim_l[ECO_MAX_STAGES];   ///< decimators, left
+    Halfband decim_r[ECO_MAX_STAGES];   ///< decimators, right
+    Halfband interp_l[ECO_MAX_STAGES];  ///< interpolators, left
+    Halfband interp_r[ECO_MAX_STAGES];  ///< interpolators, right
+    float eco_out_l[1 << ECO_MAX_STAGES];   ///< interpolated wet, left
+    float eco_out_r[1 << ECO_MAX_STAGES];   ///< interpolated wet, right
+    int eco_pos;                            ///< next sample in eco_out_*
+
+    bool mono;              ///< both sides identical, only left is processed
+    long mono_frames;       ///< frames since the last full tape cycle
+    float mono_residual;    ///< upper bound of the tapes' relative difference
+    float mono_decay;       ///< max. of feedback minus crossfeed this cycle
+    bool mono_allowed;      ///< false forces the stereo kernels
+
+    FreezeState freeze; ///< Freeze state
+    int freeze_pos;     ///< loop weight of the freeze crossfades * fade.length
+    int loop_w;         ///< write position the frozen loop ends at
+    int loop_l;         ///< position within the frozen loop, left
+    int loop_r;         ///< position within the frozen loop, right
+    int thaw;           ///< frames since the freeze was left
+
+    BollieState state;  ///< Overall state
+    bool restored;      ///< tape and delay lengths come from bd_restore()
+    bool tap_restored;  ///< tempo_tap comes from bd_restore()
+
+    const ProcessFunc* kernels; ///< kernel table for the current CPU
+};
+
+
+static const ProcessFunc* select_kernels(void);
+
+
+/**
+* Resets the resamplers used in eco mode.
+* \param self pointer to current instance
+*/
+static void eco_reset(BollieDelay* self) {
+    for (int i = 0 ; i < ECO_MAX_STAGES ; ++i) {
+        hb_reset(&self->decim_l[i]);
+        hb_reset(&self->decim_r[i]);
+        hb_reset(&self->interp_l[i]);
+        hb_reset(&self->interp_r[i]);
+    }
+    for (int i = 0 ; i < (1 << ECO_MAX_STAGES) ; ++i) {
+        self->eco_out_l[i] = 0;
+        self->eco_out_r[i] = 0;
+    }
+    self->eco_pos = 0;
+}
+
+
+/**
+* \return number of bytes needed for an instance
+*/
+size_t bd_size(void) {
+    return sizeof(BollieDelay);
+}
+
+
+/**
+* Sets up an instance in memory provided by the caller. The parameters get
+* the defaults of the LV2 plugin, the tape gets cleared by bd_reset().
+* \param mem  bd_size() bytes, aligned like malloc() does
+* \param rate sample rate
+* \return pointer to the instance, i.e. mem
+*/
+BollieDelay* bd_create(void* mem, double rate) {
+    BollieDelay* self = (BollieDelay*)mem;
+
+    // The tape is left alone, it is cleared by bd_reset()
+    memset(self, 0, offsetof(BollieDelay, tape));
+    memset(&self->buf_fill, 0, 
+        sizeof(BollieDelay) - offsetof(BollieDelay, buf_fill));
+
+    self->params[BD_TEMPO_HOST] = 120;
+    self->params[BD_TEMPO_USER] = 120;
+    self->params[BD_MIX] = 30;
+    self->params[BD_FEEDBACK] = 40;
+    self->params[BD_CROSSF] = 20;
+    self->params[BD_LOW_F] = 20;
+    self->params[BD_LOW_Q] = 1;
+    self->params[BD_HIGH_F] = 7500;
+    self->params[BD_HIGH_Q] = 1;
+
+    // Memorize sample rate for calculation
+    self->rate = rate;
+
+    // Fade in set for first delay
+    self->fade.length = ceil(rate / 50);
+    //self->fade.length = ceil(rate *4); // just for debugging
+    self->fade.pos = 0;
+
+    // bd_restore() might come before bd_reset()
+    self->tempo_tap = 120;
+
+    // Choose the fastest kernels this CPU supports
+    self->kernels = select_kernels();
+
+    // BOLLIEDELAY_MONO=0 keeps the stereo kernels, e.g. for comparison
+    const char* mono = getenv("BOLLIEDELAY_MONO");
+    self->mono_allowed = !mono || strcmp(mono, "0") != 0;
+
+    return self;
+}
+
+
+/**
+* This has to reset all the internal states. Whatever bd_restore() 
+* restored since the last bd_process() call is kept.
+* \param self pointer to current instance
+*/
+void bd_reset(BollieDelay* self) {
+    // A restored state brings its own tape and delay lengths
+    if (!self->restored) {
+        // Let's remove all that noise
+        memset(self->tape, 0, sizeof(self->tape));
+        self->state = FILL_BUF;
+
+        self->buf_fill = 0;
+
+        // Initialize number of samples needed
+        self->d_samples_l = 0;
+        self->d_samples_r = 0;
+
+        self->w_pos = 0;
+        self->tape_mask = TAPE_MASK;
+        self->cur_tempo = 0;
+        self->cur_div_l = 0;
+        self->cur_div_r = 0;
+        self->cur_quality = 0;
+        self->eco_stages = 0;
+    }
+    if (!self->tap_restored)
+        self->tempo_tap = 120;
+
+    // Clear the filters
+    bf_reset(&self->filter_low_l);
+    bf_reset(&self->filter_low_r);
+    bf_reset(&self->filter_high_l);
+    bf_reset(&self->filter_high_r);
+
+    // Reset the state variables
+    eco_reset(self);
+    self->dry_gain = 0;
+
+    // Both sides start out identical, unless the tape was restored
+    self->mono = false;
+    self->mono_frames = 0;
+    self->mono_residual = (self->restored ? 1 : 0);
+    self->mono_decay = 0;
+    self->wet_gain = 0;
+
+    // Not frozen, the freeze control takes it from here
+    self->freeze = FREEZE_OFF;
+    self->freeze_pos = 0;
+
+    // Reset tapping
+    self->since_tap = -1;
+}
+
+
+/**
+* Handles a tap on the tap button and calculates time differences. Time is
+* measured in samples processed since the last tap, so this is safe to call
+* from bd_process().
+* \param self pointer to current instance
+* \return Beats per minute or zero if it didn't work
+*/
+static float handle_tap(BollieDelay* self) {
+
+    float d = 0;
+
+    // If a previous tap is memorized, do some calculations
+    if (self->since_tap >= 0) {
+        // convert it to milliseconds
+        d = self->since_tap * 1000 / self->rate;
+
+        // Reset if we exceed the maximum delay time
+        if (d <= 50 || d > 10000 ) {
+            d = 0;
+        }
+    }
+    self->since_tap = 0;
+    return (d > 0 ? 60000 / d : 0);   // convert to bpm
+}
+
+
+/**
+* Calculates number of samples used for divided delay times.
+* \param self pointer to current instance.
+* \param tempo Tempo in BPM
+* \param div   Divider
+* \return number of samples needed for the delay buffer
+* \todo divider enum
+*/
+static int calc_delay_samples(BollieDelay* self, float tempo, int div) {
+    // Calculate the samples needed at the tape's rate
+    float d = 60 / tempo * self->rate / (1 << self->eco_stages);
+    switch(div) {
+        case 1:
+        d = d * 2/3;
+            break;
+        case 2:
+        d = d / 2;
+            break;
+        case 3:
+        d = d / 4 * 3;
+            break;
+        case 4:
+        d = d / 3;
+            break;
+        case 5:
+            d = d / 4;
+            break;
+    }
+    /* This is the length of the feedback loop, so it has to be the full
+    period. In eco mode the resamplers add a constant latency of about 4.6
+    (half) or 13.8 (quarter rate) host samples to every repeat. */
+    return floor(d);
+}
+
+
+/**
+* Tape state, held on the stack while processing a block
+*/
+typedef struct {
+    BollieState state;      ///< Overall state
+    float fc;               ///< fade coefficient
+    float cur_feedback;     ///< current feedback gain
+    float cur_crossf;       ///< current crossfeed gain
+    float target_feedback;  ///< target feedback gain
+    float target_crossf;    ///< target crossfeed gain
+    int buf_fill;           ///< current fill level
+    int d_samples_l;        ///< delay time in tape samples, left
+    int d_samples_r;        ///< delay time in tape samples, right
+    int w_pos;              ///< write position
+    int mask;               ///< ring size - 1
+    FreezeState freeze;     ///< Freeze state
+    int freeze_pos;         ///< loop weight * fade length, s. freeze_frame()
+    int loop_l;             ///< position within the frozen loop, left
+    int loop_r;             ///< position within the frozen loop, right
+    int thaw;               ///< frames since the freeze was left
+} TapeHead;
+
+
+/**
+* Reads the next frame of the frozen loop, i.e. the last delay time before
+* loop_w, and advances the loop positions.
+* \param self   pointer to current instance
+* \param loop_l position within the loop, left
+* \param loop_r position within the loop, right
+* \param old_l  returns the loop sample, left
+* \param old_r  returns the loop sample, right
+* \param mono   only the left side is read, s. update_mono()
+*/
+static inline __attribute__((always_inline)) void loop_frame(
+    BollieDelay* self, int* loop_l, int* loop_r, float* old_l, float* old_r,
+    const bool mono) {
+
+    *old_l = self->tape[(self->loop_w - self->d_samples_l + *loop_l)
+        & self->tape_mask][0];
+    if (++*loop_l == self->d_samples_l)
+        *loop_l = 0;
+
+    if (mono) {
+        *old_r = *old_l;
+    }
+    else {
+        *old_r = self->tape[(self->loop_w - self->d_samples_r + *loop_r)
+            & self->tape_mask][1];
+        if (++*loop_r == self->d_samples_r)
+            *loop_r = 0;
+    }
+}
+
+
+/**
+* Picks up the repeats where the frozen loop is, when leaving the freeze.
+* The write head is still where the loop ends, so for one delay time the
+* repeats are read from the loop instead of the tape. By then the tape 
+* written since comes round and carries on in phase.
+* \param self   pointer to current instance
+* \param tp     tape state
+* \param old_l  in: repeat read from the tape, out: repeat to use, left
+* \param old_r  in: repeat read from the tape, out: repeat to use, right
+* \param mono   only the left side is processed, s. update_mono()
+*/
+static inline __attribute__((always_inline)) void thaw_frame(
+    BollieDelay* self, TapeHead* tp, float* old_l, float* old_r, 
+    const bool mono) {
+
+    if (tp->thaw >= tp->d_samples_l && tp->thaw >= tp->d_samples_r)
+        return;
+
+    float loop_s_l, loop_s_r;
+    loop_frame(self, &tp->loop_l, &tp->loop_r, &loop_s_l, &loop_s_r, mono);
+    if (tp->thaw < tp->d_samples_l)
+        *old_l = loop_s_l;
+    if (mono)
+        *old_r = *old_l;
+    else if (tp->thaw < tp->d_samples_r)
+        *old_r = loop_s_r;
+    tp->thaw++;
+}
+
+
+/**
+* Crossfades the frame just written in or out of the freeze. It is moved
+* towards the repeats it was made from, so at full weight the tape repeats
+* itself without a step where the loop wraps.
+* \param self   pointer to current instance
+* \param tp     tape state
+* \param frame  frame just written
+* \param old_l  repeat the frame was made from, left
+* \param old_r  repeat the frame was made from, right
+* \param mono   only the left side is processed, s. update_mono()
+*/
+static inline __attribute__((always_inline)) void freeze_frame(
+    BollieDelay* self, TapeHead* tp, float* frame, const float old_l,
+    const float old_r, const bool mono) {
+
+    // Freezes only happen in CYCLE, so the repeats are at full level
+    const float g = tp->freeze_pos * (1/(float)self->fade.length);
+    frame[0] += (old_l - frame[0]) * g;
+    frame[1] = (mono ? frame[0] : frame[1] + (old_r - frame[1]) * g);
+
+    if (tp->freeze == FREEZE_IN) {
+        if (tp->freeze_pos < self->fade.length)
+            tp->freeze_pos++;
+    }
+    else if (tp->freeze_pos > 0) {
+        tp->freeze_pos--;
+    }
+}
+
+
+/**
+* Advances the tape by one frame: runs the fade state machine, reads the old
+* samples, writes the new ones including feedback and crossfeed.
+* \param self   pointer to current instance
+* \param tp     tape state
+* \param fs_l   filtered input sample, left
+* \param fs_r   filtered input sample, right
+* \param old_l  returns the faded tape sample, left
+* \param old_r  returns the faded tape sample, right
+* \param steady state is CYCLE for the whole block
+* \param mono   only the left side is processed, s. update_mono()
+*/
+static inline __attribute__((always_inline)) void tape_frame(
+    BollieDelay* self, TapeHead* tp, const float fs_l, const float fs_r,
+    float* old_l, float* old_r, const bool steady, const bool mono) {
+
+    Fade* f = &self->fade;
+
+    // Previous samples
+    float old_s_l = 0;
+    float old_s_r = 0;
+
+    // Calculates the fade coeff. This also increases
+    // the internal fade position.
+    if (steady) {
+        tp->fc = 1;
+    }
+    else {
+        switch (tp->state) {
+            case FADE_OUT:
+                if (f->pos > 0) {
+                    tp->fc = --f->pos * (1/(float)f->length);
+                }
+                else {
+                    tp->fc = 0;
+                    BDL_TRACE2(state, tp->state, FADE_OUT_DONE);
+                    tp->state = FADE_OUT_DONE;
+                }
+                break;
+            case FADE_OUT_DONE:
+                tp->fc = 0; // keep it at zero
+                break;
+            case FILL_BUF:
+                // If the buffer is filled, initiate a fade in
+                if (tp->buf_fill >= tp->d_samples_l &&
+                    tp->buf_fill >= tp->d_samples_r
+                ) {
+                    BDL_TRACE2(state, tp->state, FADE_IN);
+                    tp->state = FADE_IN;
+                }
+                tp->fc = 0;
+                break;
+            case FADE_IN:   
+                if (f->pos < f->length) {
+                    tp->fc = f->pos++ * (1/(float)f->length);
+                }
+                else {
+                    BDL_TRACE2(state, tp->state, CYCLE);
+                    tp->state = CYCLE;
+                    tp->fc = 1;
+                }
+                break;
+            case CYCLE: 
+            default:
+                tp->fc = 1;
+                break;
+        }
+    }
+
+    // In these state retrieve old samples from delay buffer
+    if (steady || tp->state == FADE_IN || tp->state == FADE_OUT || 
+        tp->state == CYCLE) {
+            const int rl_pos = (tp->w_pos - tp->d_samples_l) & tp->mask;
+            const int rr_pos = (tp->w_pos - tp->d_samples_r) & tp->mask;
+            old_s_l = self->tape[rl_pos][0] * tp->fc;
+            old_s_r = mono ? old_s_l : self->tape[rr_pos][1] * tp->fc;
+    }
+
+    // Leaving a freeze, the repeats come from the loop for a while
+    if (!steady && tp->freeze == FREEZE_OUT)
+        thaw_frame(self, tp, &old_s_l, &old_s_r, mono);
+
+    /* Feedback and Crossfeed filling the buffer */
+
+    // parameter smoothing for feedback/crossfeed
+    tp->cur_feedback = tp->target_feedback * 0.01f + tp->cur_feedback * 0.99f;
+    tp->cur_crossf = tp->target_crossf * 0.01f + tp->cur_crossf * 0.99f;
+
+    float* frame = self->tape[tp->w_pos];
+    if (mono) {
+        // Both tapes get the same sample, so leaving mono needs no copying
+        const float s = fs_l
+            + old_s_l * (tp->cur_crossf + tp->cur_feedback);
+        frame[0] = s;
+        frame[1] = s;
+    }
+    else {
+        // Left Channel
+        frame[0] = fs_l                     // current filtered sample
+            + old_s_r * tp->cur_crossf      // crossfeed sample
+            + old_s_l * tp->cur_feedback    // feedback sample
+        ;
+
+        // Right channel (s. above)
+        frame[1] = fs_r
+            + old_s_l * tp->cur_crossf
+            + old_s_r * tp->cur_feedback
+        ;
+    }
+
+    // Moving in or out of a freeze
+    if (!steady && tp->freeze != FREEZE_OFF)
+        freeze_frame(self, tp, frame, old_s_l, old_s_r, mono);
+
+    // Increase buf fill count, until both sides are filled
+    if (!steady) {
+        if (tp->buf_fill < tp->d_samples_l || tp->buf_fill < tp->d_samples_r)
+            tp->buf_fill++;
+    }
+
+    // Iterate write position, the read positions follow
+    tp->w_pos = (tp->w_pos + 1) & tp->mask;
+
+    *old_l = old_s_l;
+    *old_r = old_s_r;
+}
+
+
+/**
+* Interpolates a wet sample at the tape's rate back to the host rate.
+* \param self   pointer to current instance
+* \param wet_l  wet sample at the tape's rate, left
+* \param wet_r  wet sample at the tape's rate, right
+* \param mono   only the left side is processed, s. update_mono()
+*/
+static inline __attribute__((always_inline)) void eco_interpolate(
+    BollieDelay* self, const float wet_l, const float wet_r, 
+    const bool mono) {
+
+    if (self->eco_stages > 1) {
+        float mid_l[2], mid_r[2];
+        hb_interpolate(&self->interp_l[1], wet_l, mid_l);
+        hb_interpolate(&self->interp_l[0], mid_l[0], self->eco_out_l);
+        hb_interpolate(&self->interp_l[0], mid_l[1], self->eco_out_l+2);
+        if (!mono) {
+            hb_interpolate(&self->interp_r[1], wet_r, mid_r);
+            hb_interpolate(&self->interp_r[0], mid_r[0], self->eco_out_r);
+            hb_interpolate(&self->interp_r[0], mid_r[1], self->eco_out_r+2);
+        }
+    }
+    else {
+        hb_interpolate(&self->interp_l[0], wet_l, self->eco_out_l);
+        if (!mono)
+            hb_interpolate(&self->interp_r[0], wet_r, self->eco_out_r);
+    }
+    self->eco_pos = 0;
+}
+
+
+/**
+* Runs the tape at a reduced rate for one frame at the host rate. The input
+* is decimated by the halfband cascade, the tape advances whenever the last
+* stage yields a sample and the wet signal is interpolated back.
+* \param self   pointer to current instance
+* \param tp     tape state
+* \param fs_l   filtered input sample, left
+* \param fs_r   filtered input sample, right
+* \param old_l  returns the wet sample at the host rate, left
+* \param old_r  returns the wet sample at the host rate, right
+* \param steady state is CYCLE for the whole block
+* \param mono   only the left side is processed, s. update_mono()
+*/
+static inline __attribute__((always_inline)) void eco_frame(
+    BollieDelay* self, TapeHead* tp, float fs_l, float fs_r,
+    float* old_l, float* old_r, const bool steady, const bool mono) {
+
+    int ready = hb_decimate(&self->decim_l[0], &fs_l);
+    if (!mono)
+        hb_decimate(&self->decim_r[0], &fs_r);
+    if (ready && self->eco_stages > 1) {
+        ready = hb_decimate(&self->decim_l[1], &fs_l);
+        if (!mono)
+            hb_decimate(&self->decim_r[1], &fs_r);
+    }
+
+    if (ready) {
+        float wet_l, wet_r;
+        tape_frame(self, tp, fs_l, fs_r, &wet_l, &wet_r, steady, mono);
+        eco_interpolate(self, wet_l, wet_r, mono);
+    }
+
+    *old_l = self->eco_out_l[self->eco_pos];
+    *old_r = mono ? *old_l : self->eco_out_r[self->eco_pos];
+    self->eco_pos++;
+}
+
+
+/**
+* Processes a block of frames. All the arguments flagged as const bool are
+* compile time constants in the kernels below, so the compiler drops the
+* branches for disabled filters and the state machine in steady state.
+* \param self      pointer to current instance
+* \param t         gain targets for this block
+* \param n_samples number of samples in this current input block.
+* \param low_on    LCF enabled
+* \param high_on   HCF enabled
+* \param steady    state is CYCLE for the whole block
+* \param eco       tape runs at a reduced rate, s. eco_frame()
+* \param mono      both sides are identical, s. update_mono()
+*/
+static inline __attribute__((always_inline)) void process_frames(
+    BollieDelay* self, const GainTargets* t, uint32_t n_samples,
+    const bool low_on, const bool high_on, const bool steady, 
+    const bool eco, const bool mono) {
+
+    // Filter coefficients only change per block
+    const float* p = self->params;
+    if (low_on) {
+        bf_lcf_coeffs(p[BD_LOW_F], p[BD_LOW_Q], self->rate,
+            &self->filter_low_l);
+        if (!mono)
+            bf_lcf_coeffs(p[BD_LOW_F], p[BD_LOW_Q], self->rate,
+                &self->filter_low_r);
+    }
+    if (high_on) {
+        bf_hcf_coeffs(p[BD_HIGH_F], p[BD_HIGH_Q], self->rate,
+            &self->filter_high_l);
+        if (!mono)
+            bf_hcf_coeffs(p[BD_HIGH_F], p[BD_HIGH_Q], self->rate,
+                &self->filter_high_r);
+    }
+
+    // State stuff to get more from heap to stack
+    const float target_dry_gain = t->dry_gain;
+    const float target_wet_gain = t->wet_gain;
+    float dry_gain = self->dry_gain;
+    float wet_gain = self->wet_gain;
+    TapeHead tp;
+    tp.state = self->state;
+    tp.fc = 0;
+    tp.cur_feedback = self->cur_feedback;
+    tp.cur_crossf = self->cur_crossf;
+    tp.target_feedback = t->feedback;
+    tp.target_crossf = t->crossf;
+    tp.buf_fill = self->buf_fill;
+    tp.d_samples_l = self->d_samples_l;
+    tp.d_samples_r = self->d_samples_r;
+    tp.w_pos = self->w_pos;
+    tp.mask = self->tape_mask;
+    tp.freeze = self->freeze;
+    tp.freeze_pos = self->freeze_pos;
+    tp.loop_l = self->loop_l;
+    tp.loop_r = self->loop_r;
+    tp.thaw = self->thaw;
+
+    // Loop over the block of audio we got, chunk by chunk
+    for (uint32_t offset = 0 ; offset < n_samples ; offset += BDL_CHUNK) {
+        const uint32_t n = (n_samples - offset < BDL_CHUNK ? 
+            n_samples - offset : BDL_CHUNK);
+        const float* in_l = self->input_l + offset;
+        const float* in_r = self->input_r + offset;
+        float* out_l = self->output_l + offset;
+        float* out_r = self->output_r + offset;
+
+        // Samples going to the tape
+        const float* fs_l = in_l;
+        const float* fs_r = in_r;
+        float filtered_l[BDL_CHUNK];
+        float filtered_r[BDL_CHUNK];
+
+        // Apply the low and/or high cut filter if enabled
+        if (low_on || high_on) {
+            BDL_TRACE1(filter_begin, n);
+            for (uint32_t i = 0 ; i < n ; ++i) {
+                float cur_fs_l = in_l[i];
+                float cur_fs_r = in_r[i];
+                if (low_on) {
+                    cur_fs_l = bf_process(cur_fs_l, &self->filter_low_l);
+                    if (!mono)
+                        cur_fs_r = bf_process(cur_fs_r, &self->filter_low_r);
+                }
+                if (high_on) {
+                    cur_fs_l = bf_process(cur_fs_l, &self->filter_high_l);
+                    if (!mono)
+                        cur_fs_r = bf_process(cur_fs_r, &self->filter_high_r);
+                }
+                filtered_l[i] = cur_fs_l;
+                filtered_r[i] = cur_fs_r;
+            }
+            fs_l = filtered_l;
+            fs_r = filtered_r;
+            BDL_TRACE(filter_end);
+        }
+
+        BDL_TRACE2(tape_begin, n, tp.state);
+        for (uint32_t i = 0 ; i < n ; ++i) {
+            float old_s_l, old_s_r;
+            if (eco)
+                eco_frame(self, &tp, fs_l[i], fs_r[i], &old_s_l, &old_s_r,
+                    steady, mono);
+            else
+                tape_frame(self, &tp, fs_l[i], fs_r[i], &old_s_l, &old_s_r,
+                    steady, mono);
+
+            // Paraemter smoothing for wet and dry gain
+            wet_gain = target_wet_gain * 0.01f + wet_gain * 0.99f;
+            dry_gain = target_dry_gain * 0.01f + dry_gain * 0.99f;
+
+            // Will it blend? ;)
+            out_l[i] = dry_gain * in_l[i] + wet_gain * old_s_l;
+            out_r[i] = (mono ? out_l[i] : 
+                dry_gain * in_r[i] + wet_gain * old_s_r);
+        }
+        BDL_TRACE(tape_end);
+    }
+
+    // Memorize state for next run
+    self->state = tp.state;
+    self->buf_fill = tp.buf_fill;
+    self->w_pos = tp.w_pos;
+    self->wet_gain = wet_gain;
+    self->dry_gain = dry_gain;
+    self->cur_crossf = tp.cur_crossf;
+    self->cur_feedback = tp.cur_feedback;
+    self->freeze_pos = tp.freeze_pos;
+    self->loop_l = tp.loop_l;
+    self->loop_r = tp.loop_r;
+    self->thaw = tp.thaw;
+}
+
+
+/**
+* Generates one specialised kernel per filter on/off combination,
+* steady/transitional state, full/eco rate and stereo/mono for the given
+* instruction set.
+*/
+#define BDL_KERNEL(isa, attr, low, high, steady, eco, mono) \
+static attr void process_##isa##_##low##high##steady##eco##mono( \
+    BollieDelay* self, const GainTargets* t, uint32_t n_samples) { \
+    process_frames(self, t, n_samples, low, high, steady, eco, mono); \
+}
+
+#define BDL_KERNEL_FILTERS(isa, attr, steady, eco, mono) \
+    BDL_KERNEL(isa, attr, 0, 0, steady, eco, mono) \
+    BDL_KERNEL(isa, attr, 1, 0, steady, eco, mono) \
+    BDL_KERNEL(isa, attr, 0, 1, steady, eco, mono) \
+    BDL_KERNEL(isa, attr, 1, 1, steady, eco, mono)
+
+#define BDL_KERNEL_PTRS(isa, steady, eco, mono) \
+    process_##isa##_00##steady##eco##mono, \
+    process_##isa##_10##steady##eco##mono, \
+    process_##isa##_01##steady##eco##mono, \
+    process_##isa##_11##steady##eco##mono
+
+/**
+* Generates the full kernel table for the given instruction set. The table
+* is indexed by KERNEL_IDX().
+*/
+#define BDL_KERNEL_SET(isa, attr) \
+    BDL_KERNEL_FILTERS(isa, attr, 0, 0, 0) \
+    BDL_KERNEL_FILTERS(isa, attr, 1, 0, 0) \
+    BDL_KERNEL_FILTERS(isa, attr, 0, 1, 0) \
+    BDL_KERNEL_FILTERS(isa, attr, 1, 1, 0) \
+    BDL_KERNEL_FILTERS(isa, attr, 0, 0, 1) \
+    BDL_KERNEL_FILTERS(isa, attr, 1, 0, 1) \
+    BDL_KERNEL_FILTERS(isa, attr, 0, 1, 1) \
+    BDL_KERNEL_FILTERS(isa, attr, 1, 1, 1) \
+    static const ProcessFunc kernels_##isa[32] = { \
+        BDL_KERNEL_PTRS(isa, 0, 0, 0), BDL_KERNEL_PTRS(isa, 1, 0, 0), \
+        BDL_KERNEL_PTRS(isa, 0, 1, 0), BDL_KERNEL_PTRS(isa, 1, 1, 0), \
+        BDL_KERNEL_PTRS(isa, 0, 0, 1), BDL_KERNEL_PTRS(isa, 1, 0, 1), \
+        BDL_KERNEL_PTRS(isa, 0, 1, 1), BDL_KERNEL_PTRS(isa, 1, 1, 1), \
+    };
+
+#define KERNEL_IDX(low, high, steady, eco, mono) \
+    ((low ? 1 : 0) | (high ? 2 : 0) | (steady ? 4 : 0) | (eco ? 8 : 0) | \
+    (mono ? 16 : 0))
+
+BDL_KERNEL_SET(default, )
+
+#ifdef BDL_X86_DISPATCH
+/* The per sample filter and halfband state must stay in 128 bit vectors,
+   wider SLP stores of that state stall store forwarding on the next read. */
+#define BDL_ISA_AVX2 "avx2,fma,prefer-vector-width=128"
+#define BDL_ISA_AVX512 "avx512f,avx512vl,avx2,fma,prefer-vector-width=128"
+
+BDL_KERNEL_SET(avx2, __attribute__((target(BDL_ISA_AVX2))))
+BDL_KERNEL_SET(avx512, __attribute__((target(BDL_ISA_AVX512))))
+#endif
+
+
+/**
+* Processes a block while frozen. The tape is only read, looping the last
+* delay time of each side, and mixed with the input. Neither the filters
+* nor the writes and feedback run, in eco mode the decimators just keep 
+* their phase.
+* \param self      pointer to current instance
+* \param t         gain targets for this block
+* \param n_samples number of samples in this current input block.
+* \param eco       tape runs at a reduced rate, s. eco_frame()
+* \param mono      both sides are identical, s. update_mono()
+*/
+static inline __attribute__((always_inline)) void frozen_frames(
+    BollieDelay* self, const GainTargets* t, uint32_t n_samples,
+    const bool eco, const bool mono) {
+
+    const float target_dry_gain = t->dry_gain;
+    const float target_wet_gain = t->wet_gain;
+    float dry_gain = self->dry_gain;
+    float wet_gain = self->wet_gain;
+    int loop_l = self->loop_l;
+    int loop_r = self->loop_r;
+    const float* in_l = self->input_l;
+    const float* in_r = self->input_r;
+    float* out_l = self->output_l;
+    float* out_r = self->output_r;
+
+    BDL_TRACE2(tape_begin, n_samples, CYCLE);
+    for (uint32_t i = 0 ; i < n_samples ; ++i) {
+        float old_s_l, old_s_r;
+        if (eco) {
+            // The tape advances, where the decimators would yield a sample
+            int ready = hb_skip(&self->decim_l[0]);
+            if (!mono)
+                hb_skip(&self->decim_r[0]);
+            if (ready && self->eco_stages > 1) {
+                ready = hb_skip(&self->decim_l[1]);
+                if (!mono)
+                    hb_skip(&self->decim_r[1]);
+            }
+            if (ready) {
+                float wet_l, wet_r;
+                loop_frame(self, &loop_l, &loop_r, &wet_l, &wet_r, mono);
+                eco_interpolate(self, wet_l, wet_r, mono);
+            }
+            old_s_l = self->eco_out_l[self->eco_pos];
+            old_s_r = mono ? old_s_l : self->eco_out_r[self->eco_pos];
+            self->eco_pos++;
+        }
+        else {
+            loop_frame(self, &loop_l, &loop_r, &old_s_l, &old_s_r, mono);
+        }
+
+        // Parameter smoothing for wet and dry gain
+        wet_gain = target_wet_gain * 0.01f + wet_gain * 0.99f;
+        dry_gain = target_dry_gain * 0.01f + dry_gain * 0.99f;
+
+        out_l[i] = dry_gain * in_l[i] + wet_gain * old_s_l;
+        out_r[i] = (mono ? out_l[i] : 
+            dry_gain * in_r[i] + wet_gain * old_s_r);
+    }
+    BDL_TRACE(tape_end);
+
+    self->wet_gain = wet_gain;
+    self->dry_gain = dry_gain;
+    self->loop_l = loop_l;
+    self->loop_r = loop_r;
+}
+
+
+/**
+* Generates the frozen kernels for full/eco rate and stereo/mono. A plain 
+* read and mix has nothing to gain from wider instruction sets, so there is
+* only one set.
+*/
+#define BDL_FROZEN(eco, mono) \
+static void process_frozen_##eco##mono( \
+    BollieDelay* self, const GainTargets* t, uint32_t n_samples) { \
+    frozen_frames(self, t, n_samples, eco, mono); \
+}
+
+BDL_FROZEN(0, 0)
+BDL_FROZEN(1, 0)
+BDL_FROZEN(0, 1)
+BDL_FROZEN(1, 1)
+
+static const ProcessFunc kernels_frozen[4] = {
+    process_frozen_00, process_frozen_10, process_frozen_01, process_frozen_11
+};
+
+#define FROZEN_IDX(eco, mono) ((eco ? 1 : 0) | (mono ? 2 : 0))
+
+
+/**
+* Picks the kernel table for the CPU we are running on. The environment
+* variable BOLLIEDELAY_ISA (sse2, avx2 or avx512) can be used to force a
+* lower instruction set, e.g. for benchmarking.
+* \return kernel table, indexed by KERNEL_IDX()
+*/
+static const ProcessFunc* select_kernels(void) {
+#ifdef BDL_X86_DISPATCH
+    const char* isa = getenv("BOLLIEDELAY_ISA");
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && 
+        __builtin_cpu_supports("avx512vl") &&
+        (!isa || strcmp(isa, "avx512") == 0)) {
+        return kernels_avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+        (!isa || strcmp(isa, "avx512") == 0 || strcmp(isa, "avx2") == 0)) {
+        return kernels_avx2;
+    }
+#endif
+    return kernels_default;
+}
+
+
+/**
+* Brings the right side up to date with the left one after processing in
+* mono. The tapes are written on both sides in mono and share the write
+* position, so only the filters and resamplers need to be copied.
+* \param self pointer to current instance
+*/
+static void leave_mono(BollieDelay* self) {
+    self->filter_low_r = self->filter_low_l;
+    self->filter_high_r = self->filter_high_l;
+    for (int i = 0 ; i < ECO_MAX_STAGES ; ++i) {
+        self->decim_r[i] = self->decim_l[i];
+        self->interp_r[i] = self->interp_l[i];
+    }
+    for (int i = 0 ; i < (1 << ECO_MAX_STAGES) ; ++i)
+        self->eco_out_r[i] = self->eco_out_l[i];
+    self->loop_r = self->loop_l;
+
+    self->mono = false;
+}
+
+
+/**
+* Bounds the difference, that the right side's filters and decimators can
+* still add to its tape compared to the left ones, if both sides get the same
+* input from now on. Disabled filters don't reach the tapes.
+* \param self pointer to current instance
+* \return upper bound of the difference of the written samples
+*/
+static float input_divergence(const BollieDelay* self) {
+    float d = 0;
+    if (self->params[BD_LOW_ON])
+        d += bf_divergence(&self->filter_low_l, &self->filter_low_r);
+    if (self->params[BD_HIGH_ON])
+        d += bf_divergence(&self->filter_high_l, &self->filter_high_r);
+    for (int i = 0 ; i < self->eco_stages ; ++i)
+        d += hb_divergence(&self->decim_l[i], &self->decim_r[i]);
+    return d;
+}
+
+
+/**
+* Bounds the difference, that the right side's interpolators can still add
+* to its output compared to the left ones, if both tapes play the same from
+* now on. The second stage's output runs through both paths of the first.
+* \param self pointer to current instance
+* \return upper bound of the difference of the output samples
+*/
+static float output_divergence(const BollieDelay* self) {
+    if (self->eco_stages == 0)
+        return 0;
+
+    float d = hb_divergence(&self->interp_l[0], &self->interp_r[0]);
+    if (self->eco_stages > 1)
+        d += HB_GAIN * hb_divergence(&self->interp_l[1], &self->interp_r[1]);
+    for (int i = self->eco_pos ; i < (1 << self->eco_stages) ; ++i)
+        d = fmaxf(d, fabsf(self->eco_out_l[i] - self->eco_out_r[i]));
+    return d;
+}
+
+
+/**
+* Decides whether the next block can be processed by the mono kernels. This
+* is the case, if both inputs and delay times match, the right side's
+* filters and resamplers have caught up with the left ones and whatever is
+* left of earlier differences on the tapes has decayed. As the crossfeed is
+* symmetric, the difference between the tapes scales by feedback minus
+* crossfeed per tape cycle. Only the frames processed before this block
+* count, as they are the ones on the tapes.
+* \param self      pointer to current instance
+* \param t         gain targets for this block
+* \param n_samples number of samples in this current input block.
+*/
+static void update_mono(BollieDelay* self, const GainTargets* t,
+    uint32_t n_samples) {
+
+    if (!self->mono_allowed)
+        return;
+
+    const bool same = 
+        self->d_samples_l == self->d_samples_r &&
+        (self->input_l == self->input_r ||
+            memcmp(self->input_l, self->input_r, 
+                n_samples * sizeof(float)) == 0);
+
+    if (!same) {
+        if (self->mono)
+            leave_mono(self);
+        self->mono_frames = 0;
+        self->mono_residual = 1;
+        self->mono_decay = 0;
+        return;
+    }
+    if (self->mono)
+        return;
+
+    // The tapes are not written while frozen, so they don't converge either
+    if (self->freeze != FREEZE_OFF) {
+        self->mono_frames = 0;
+        self->mono_decay = 0;
+        return;
+    }
+
+    // Differences still ringing out of the filters end up on the tapes
+    if (input_divergence(self) >= MONO_RESIDUAL) {
+        self->mono_frames = 0;
+        self->mono_residual = 1;
+        self->mono_decay = 0;
+        return;
+    }
+
+    if (self->mono_residual < MONO_RESIDUAL &&
+        output_divergence(self) < MONO_RESIDUAL) {
+        self->mono = true;
+        return;
+    }
+
+    /* The gains only move from the current towards the target values in
+    this block. Every frame of a cycle is scaled by the gains it was written
+    with, so a cycle decays by the largest of them. */
+    float decay = fabsf(t->feedback - t->crossf);
+    if (fabsf(self->cur_feedback - self->cur_crossf) > decay)
+        decay = fabsf(self->cur_feedback - self->cur_crossf);
+    if (decay > self->mono_decay)
+        self->mono_decay = decay;
+
+    // Count the tape cycles, that are complete after this block
+    const long cycle = (long)self->d_samples_l << self->eco_stages;
+    self->mono_frames += n_samples;
+    while (self->mono_frames >= cycle && self->mono_residual >= MONO_RESIDUAL) {
+        self->mono_frames -= cycle;
+        self->mono_residual *= self->mono_decay;
+
+        // The next cycle starts within this block
+        self->mono_decay = decay;
+    }
+}
+
+
+/**
+* Processes a block of audio with the current parameters. Input and output
+* buffers may be the same.
+* \param self      pointer to current instance
+* \param in_l      input, left side
+* \param in_r      input, right side
+* \param out_l     output, left side
+* \param out_r     output, right side
+* \param n_samples number of samples in this current input block.
+*/
+void bd_process(BollieDelay* self, const float* in_l, const float* in_r,
+    float* out_l, float* out_r, uint32_t n_samples) {
+
+    BDL_TRACE1(params_begin, n_samples);
+    BollieState state = self->state;
+    const float* p = self->params;
+
+    self->input_l = in_l;
+    self->input_r = in_r;
+    self->output_l = out_l;
+    self->output_r = out_r;
+
+    // From now on bd_reset() starts from scratch again
+    self->restored = false;
+    self->tap_restored = false;
+
+    // First some TAP handling
+    if (p[BD_TAP] > 0) {
+        float d = handle_tap(self);
+        if (d > 0) 
+            self->tempo_tap = (float)d;
+    }
+
+    // Count the time until the next tap, no need to go beyond the maximum
+    if (self->since_tap >= 0 && self->since_tap <= self->rate * 10)
+        self->since_tap += n_samples;
+
+    // Handle tempo mode
+    float tempo = p[BD_TEMPO_HOST]; 
+    switch ((int)(p[BD_TEMPO_MODE])) {
+        case 1:
+            tempo = p[BD_TEMPO_USER];
+            break;
+        case 2:
+            tempo = self->tempo_tap;
+            break;
+    }
+
+    // Tempo changes always initiate a fade out. While frozen the loop is
+    // held, changes apply once the freeze is left.
+    if (self->freeze == FREEZE_OFF && (tempo != self->cur_tempo ||
+        p[BD_DIV_L] != self->cur_div_l ||
+        p[BD_DIV_R] != self->cur_div_r ||
+        p[BD_QUALITY] != self->cur_quality)
+    ) {
+        // If the fade out is done, resize buffer and get everything set for 
+        // filling the buffers.
+        if (state == FADE_OUT_DONE) {
+            // The delay times are about to change
+            if (self->mono)
+                leave_mono(self);
+
+            // Memorize the user's current settings.
+            self->cur_tempo = tempo;
+            self->cur_div_l = p[BD_DIV_L];
+            self->cur_div_r = p[BD_DIV_R];
+            self->cur_quality = p[BD_QUALITY];
+
+            // Switch the tape rate, fades run at the tape's rate as well
+            self->eco_stages = (int)p[BD_QUALITY];
+            if (self->eco_stages < 0 || self->eco_stages > ECO_MAX_STAGES)
+                self->eco_stages = 0;
+            self->fade.length = ceil(self->rate / (1 << self->eco_stages) / 50);
+            eco_reset(self);
+
+            // The ring shrinks along, so only the part in use gets touched
+            self->tape_mask = TAPE_MASK >> self->eco_stages;
+            self->w_pos &= self->tape_mask;
+
+            // Calculate the samples needed for the currently set delay time
+            self->d_samples_l = 
+                calc_delay_samples(self, tempo, p[BD_DIV_L]);
+            self->d_samples_r =
+                calc_delay_samples(self, tempo, p[BD_DIV_R]);
+
+            /* The delay time must not exceed MAX_TAPE_LEN-1 at full rate,
+            which still fits the ring with some room for the write head. Cut
+            the number of samples, if needed */
+            const int max_d = (MAX_TAPE_LEN-1) >> self->eco_stages;
+            if (self->d_samples_l > max_d)
+                self->d_samples_l = max_d;
+
+            if (self->d_samples_r > max_d)
+                self->d_samples_r = max_d;
+
+            // Pretend the buffer to be empty, the write head keeps going
+            self->buf_fill = 0;
+
+            // Ready to fill buffer
+            BDL_TRACE2(state, state, FILL_BUF);
+            state = FILL_BUF;
+        }
+        else if (state != FADE_OUT) {
+             // If we reach this, tempo has been changed, but no fade out
+             // has been done yet.
+             BDL_TRACE2(state, state, FADE_OUT);
+             state = FADE_OUT;
+        }
+    }
+
+    /* Freezing crossfades the writes into copies of the repeats, after that
+    the tape is only read. Leaving it crossfades the writes back, while the
+    repeats carry on from the loop until the tape has come round. Both run
+    to the end, before the freeze control is looked at again. Only a 
+    cycling tape has repeats to hold. Leaving writes up to one delay time
+    past the loop, which must not reach the part of it still to be read, so
+    the loop can't be longer than half the tape. */
+    const bool freeze = p[BD_FREEZE] > 0;
+    const int max_loop = (self->tape_mask + 1) / 2;
+    if (self->freeze == FREEZE_IN && self->freeze_pos >= self->fade.length) {
+        self->freeze = FROZEN;
+        self->loop_w = self->w_pos;
+        self->loop_l = 0;
+        self->loop_r = 0;
+    }
+    if (self->freeze == FROZEN && !freeze) {
+        self->freeze = FREEZE_OUT;
+        self->thaw = 0;
+    }
+    if (self->freeze == FREEZE_OUT && self->freeze_pos <= 0 &&
+        self->thaw >= self->d_samples_l && self->thaw >= self->d_samples_r)
+        self->freeze = FREEZE_OFF;
+    if (self->freeze == FREEZE_OFF && freeze && state == CYCLE &&
+        self->d_samples_l <= max_loop && self->d_samples_r <= max_loop)
+        self->freeze = FREEZE_IN;
+
+    // Let's do the vfade gain calculation
+    GainTargets t;
+    const float cp_blend = p[BD_MIX];
+    t.dry_gain = 1;
+    t.wet_gain = 0;
+    if (cp_blend > 0 && cp_blend < 50) {
+        t.wet_gain = powf(10.0f, (cp_blend-50) * 0.04f);
+    }
+    else if (cp_blend < 100 && cp_blend > 50) {
+        t.wet_gain = 1;
+        t.dry_gain = powf(10.0f, (cp_blend-50) * -0.04f);
+    }
+    else if (cp_blend == 50) {
+        t.wet_gain = 1;
+    }
+    else if (cp_blend == 100) {
+        t.wet_gain = 1;
+        t.dry_gain = 0;
+    }
+
+    // Lets do the feedback/crossfeed calculation        
+    const float cp_feedback = p[BD_FEEDBACK];
+    t.feedback = 0;
+    if (cp_feedback > 0 && cp_feedback < 100) {
+        t.feedback = powf(10.0f, (cp_feedback-100) * 0.02f);
+    }
+    else if (cp_feedback == 100) {
+        t.feedback = 1;
+    }
+
+    const float cp_crossf = p[BD_CROSSF];
+    t.crossf = 0;
+    if (cp_crossf > 0 && cp_crossf < 100) {
+        t.crossf = powf(10.0f, (cp_crossf-100) * 0.02f);
+    }
+    else if (cp_feedback == 100) {
+        t.crossf = 1;
+    }
+
+    // Hand the block over to the matching kernel
+    BDL_TRACE(params_end);
+    self->state = state;
+    update_mono(self, &t, n_samples);
+    if (self->freeze == FROZEN) {
+        kernels_frozen[FROZEN_IDX(self->eco_stages > 0, self->mono)](self,
+            &t, n_samples);
+        return;
+    }
+    self->kernels[KERNEL_IDX(p[BD_LOW_ON], p[BD_HIGH_ON], 
+        state == CYCLE && self->freeze == FREEZE_OFF, self->eco_stages > 0,
+        self->mono)](self, &t, n_samples);
+}
+
+
+/**
+* Sets a parameter, it takes effect with the next bd_process() call.
+* \param self  pointer to current instance
+* \param param parameter
+* \param value value in the range of the matching LV2 port
+*/
+void bd_set_param(BollieDelay* self, BollieParam param, float value) {
+    if (param >= 0 && param < BD_N_PARAMS)
+        self->params[param] = value;
+}
+
+
+/**
+* \param self pointer to current instance
+* \return tempo the tape runs at, 0 before the first delay time is set
+*/
+float bd_get_tempo(const BollieDelay* self) {
+    return self->cur_tempo;
+}
+
+
+/**
+* Gets what is needed to resume the tape after a reload. Apart from the
+* tapped tempo, this is only valid while the tape is cycling. May be called
+* concurrently with bd_process().
+* \param self   pointer to current instance
+* \param recall filled with the current settings
+* \return number of frames for a tape snapshot, 0 if the tape isn't cycling
+*/
+int bd_get_recall(const BollieDelay* self, BollieRecall* recall) {
+    recall->rate = self->rate;
+    recall->tempo_tap = self->tempo_tap;
+    recall->tempo = self->cur_tempo;
+    recall->div_l = self->cur_div_l;
+    recall->div_r = self->cur_div_r;
+    recall->quality = self->cur_quality;
+    recall->d_samples_l = self->d_samples_l;
+    recall->d_samples_r = self->d_samples_r;
+
+    if (self->state != CYCLE)
+        return 0;
+    return (self->d_samples_l > self->d_samples_r ? 
+        self->d_samples_l : self->d_samples_r);
+}
+
+
+/**
+* Gets the last n frames of the tape in playing order. The ring might wrap,
+* so these come in two spans, the second one may be empty. The frames are 
+* only overwritten again by bd_process() after the ring size - n frames, so
+* they can be copied while processing goes on.
+* \param self  pointer to current instance
+* \param n     number of frames, s. bd_get_recall()
+* \param spans filled with the oldest and the newer frames
+*/
+void bd_tape_spans(const BollieDelay* self, int n, BollieSpan spans[2]) {
+    const int size = self->tape_mask + 1;
+    const int start = (self->w_pos - n) & self->tape_mask;
+    const int first = (start + n > size ? size - start : n);
+    spans[0].frames = self->tape[start];
+    spans[0].n = first;
+    spans[1].frames = self->tape[0];
+    spans[1].n = n - first;
+}
+
+
+/**
+* Resumes the tape from a recall and optionally a tape snapshot. With the
+* snapshot the repeats fade in right away, without one the tape is filled
+* first as usual. The tapped tempo is restored in any case. Must not be 
+* called concurrently with bd_process().
+* \param self   pointer to current instance
+* \param recall settings from bd_get_recall()
+* \param tape   interleaved frames in playing order or NULL
+* \param n      number of frames in tape, has to match the recall
+* \return 0 if the delay lengths were restored, 1 if they don't fit
+*/
+int bd_restore(BollieDelay* self, const BollieRecall* recall,
+    const float* tape, int n) {
+
+    self->tempo_tap = recall->tempo_tap;
+    self->tap_restored = true;
+
+    // Delay lengths only fit the sample rate they were calculated for
+    if (recall->rate != self->rate || 
+        recall->quality < 0 || recall->quality > ECO_MAX_STAGES ||
+        recall->d_samples_l <= 0 || recall->d_samples_r <= 0 ||
+        recall->d_samples_l > (MAX_TAPE_LEN-1) >> (int)recall->quality ||
+        recall->d_samples_r > (MAX_TAPE_LEN-1) >> (int)recall->quality) {
+        return 1;
+    }
+    self->restored = true;
+
+    // The delay lengths are about to change
+    if (self->mono)
+        leave_mono(self);
+    self->freeze = FREEZE_OFF;
+    self->freeze_pos = 0;
+    self->mono_frames = 0;
+    self->mono_residual = 1;
+    self->mono_decay = 0;
+
+    self->cur_tempo = recall->tempo;
+    self->cur_div_l = recall->div_l;
+    self->cur_div_r = recall->div_r;
+    self->cur_quality = recall->quality;
+    self->eco_stages = (int)recall->quality;
+    self->fade.length = ceil(self->rate / (1 << self->eco_stages) / 50);
+    self->fade.pos = 0;
+    eco_reset(self);
+    self->tape_mask = TAPE_MASK >> self->eco_stages;
+    self->d_samples_l = recall->d_samples_l;
+    self->d_samples_r = recall->d_samples_r;
+
+    const int frames = (self->d_samples_l > self->d_samples_r ? 
+        self->d_samples_l : self->d_samples_r);
+    if (tape && n == frames) {
+        memcpy(self->tape, tape, frames * sizeof(self->tape[0]));
+        self->w_pos = frames;
+        self->buf_fill = frames;
+        self->state = FADE_IN;
+    }
+    else {
+        self->buf_fill = 0;
+        self->state = FILL_BUF;
+    }
+    return 0;
+}
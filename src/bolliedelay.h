@@ -0,0 +1,116 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file bolliedelay.h
+* \author Bollie
+* \date 19 Oct 2026
+* \brief The delay engine of libbolliedelay.a, independent of any host API.
+*
+* The caller provides the memory for an instance (bd_size() bytes, aligned
+* like malloc() does), none of the functions allocate. The parameters are
+* plain values set by bd_set_param(), they are picked up by the next 
+* bd_process() call.
+*
+* Realtime safe: bd_set_param(), bd_process(), bd_get_tempo(), 
+* bd_get_recall() and bd_tape_spans().
+* Not realtime safe: bd_create(), bd_reset(), which clears the whole tape
+* (16 MB), and bd_restore(), which copies up to 15 MB of it.
+*/
+
+#ifndef __BOLLIEDELAY_H__
+#define __BOLLIEDELAY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+* Parameters, the values and ranges are the ones of the LV2 control ports
+*/
+typedef enum {
+    BD_TEMPO_HOST   = 0,    ///< Tempo in BPM from host
+    BD_TEMPO_USER   = 1,    ///< Tempo in BPM set by user
+    BD_TEMPO_MODE   = 2,    ///< Tempo mode 0=host, 1=user, 2=tap
+    BD_TAP          = 3,    ///< > 0 while tapping
+    BD_MIX          = 4,    ///< mix/blend in percentage
+    BD_FEEDBACK     = 5,    ///< feedback in percentage
+    BD_CROSSF       = 6,    ///< crossfeed in percentage between inputs
+    BD_LOW_ON       = 7,    ///< LCF: 0=off, 1=on
+    BD_LOW_F        = 8,    ///< LCF cut off frequency
+    BD_LOW_Q        = 9,    ///< LCF quality
+    BD_HIGH_ON      = 10,   ///< HCF: 0=off, 1=on
+    BD_HIGH_F       = 11,   ///< HCF cut off frequency
+    BD_HIGH_Q       = 12,   ///< HCF quality
+    BD_DIV_L        = 13,   ///< Divider enum, left
+    BD_DIV_R        = 14,   ///< Divider enum, right
+    BD_QUALITY      = 15,   ///< Tape rate 0=full, 1=half, 2=quarter
+    BD_FREEZE       = 16,   ///< > 0 holds the current repeats as a loop,
+                            ///< up to half the tape (5.4 s at 192 kHz)
+    BD_N_PARAMS
+} BollieParam;
+
+
+/**
+* Everything needed to resume a running tape, s. bd_get_recall()
+*/
+typedef struct {
+    double rate;            ///< sample rate the delay lengths belong to
+    float tempo_tap;        ///< tapped tempo
+    float tempo;            ///< tempo the delay lengths were calculated for
+    float div_l;            ///< division, left
+    float div_r;            ///< division, right
+    float quality;          ///< tape rate
+    int32_t d_samples_l;    ///< delay length in tape samples, left
+    int32_t d_samples_r;    ///< delay length in tape samples, right
+} BollieRecall;
+
+
+/**
+* A run of interleaved l/r tape frames, s. bd_tape_spans()
+*/
+typedef struct {
+    const float* frames;    ///< first frame
+    int n;                  ///< number of frames
+} BollieSpan;
+
+
+typedef struct BollieDelay BollieDelay;
+
+size_t bd_size(void);
+BollieDelay* bd_create(void* mem, double rate);
+void bd_reset(BollieDelay* self);
+void bd_set_param(BollieDelay* self, BollieParam param, float value);
+void bd_process(BollieDelay* self, const float* in_l, const float* in_r,
+    float* out_l, float* out_r, uint32_t n_samples);
+float bd_get_tempo(const BollieDelay* self);
+
+int bd_get_recall(const BollieDelay* self, BollieRecall* recall);
+void bd_tape_spans(const BollieDelay* self, int n, BollieSpan spans[2]);
+int bd_restore(BollieDelay* self, const BollieRecall* recall,
+    const float* tape, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
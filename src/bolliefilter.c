@@ -51,17 +51,14 @@ void bf_reset(BollieFilter* bf) {
 
 
 /**
-* Processes a frame using a low cut filter.
-* \param in     Input sample
+* Sets up the low cut filter coefficients, if any parameter changed.
 * \param freq   Filter cut off frequency
 * \param Q      Filter quality
 * \param rate   Current sampling rate
 * \param bf     Pointer to the BollieFilter object
-* \return       Output sample
-* \todo         Validating parameters
 */
-float bf_lcf(const float in, const float freq, const float Q, 
-    double rate, BollieFilter* bf) {
+void bf_lcf_coeffs(const float freq, const float Q, double rate,
+    BollieFilter* bf) {
 
     // Precalculate if needed.
     if (freq != bf->freq || Q != bf->Q || rate != bf->rate) {
@@ -77,42 +74,18 @@ float bf_lcf(const float in, const float freq, const float Q,
         bf->b1 = -(1 + cos(w0));
         bf->b2 = (1 + cos(w0)) / 2; 
     }
-
-    // Filter roll
-    bf->in_buf[2] = bf->in_buf[1];
-    bf->in_buf[1] = bf->in_buf[0];
-    bf->in_buf[0] = in;
-
-    bf->processed_buf[2] = bf->processed_buf[1];
-    bf->processed_buf[1] = bf->processed_buf[0];
-
-    // See if we need to fill the buffers first
-    if (bf->fill_count < 3) {
-        bf->processed_buf[0] = in;
-        bf->fill_count++;
-        return 0;
-    }
-
-    return bf->processed_buf[0] =             
-            (bf->b0 / bf->a0 * bf->in_buf[0]) +
-            (bf->b1 / bf->a0 * bf->in_buf[1]) +
-            (bf->b2 / bf->a0 * bf->in_buf[2]) -
-            (bf->a1 / bf->a0 * bf->processed_buf[1]) -
-            (bf->a2 / bf->a0 * bf->processed_buf[2]);
 }
 
 
 /**
-* Processes a frame using a high cut filter.
-* \param in     Input sample
+* Sets up the high cut filter coefficients, if any parameter changed.
 * \param freq   Filter cut off frequency
 * \param Q      Filter quality
 * \param rate   Current sampling rate
 * \param bf     Pointer to the BollieFilter object
-* \return       Output sample
 */
-float bf_hcf(const float in, const float freq, const float Q, 
-    double rate, BollieFilter* bf) {
+void bf_hcf_coeffs(const float freq, const float Q, double rate,
+    BollieFilter* bf) {
 
     // Precalculate if needed.
     if (freq != bf->freq || Q != bf->Q || rate != bf->rate) {
@@ -128,27 +101,76 @@ float bf_hcf(const float in, const float freq, const float Q,
         bf->b1 = 1 - cos(w0);
         bf->b2 = (1 - cos(w0)) / 2; 
     }
+}
 
-    // Filter roll
-    bf->in_buf[2] = bf->in_buf[1];
-    bf->in_buf[1] = bf->in_buf[0];
-    bf->in_buf[0] = in;
 
-    bf->processed_buf[2] = bf->processed_buf[1];
-    bf->processed_buf[1] = bf->processed_buf[0];
+/**
+* Processes a frame using a low cut filter.
+* \param in     Input sample
+* \param freq   Filter cut off frequency
+* \param Q      Filter quality
+* \param rate   Current sampling rate
+* \param bf     Pointer to the BollieFilter object
+* \return       Output sample
+* \todo         Validating parameters
+*/
+float bf_lcf(const float in, const float freq, const float Q, 
+    double rate, BollieFilter* bf) {
 
-    // See if we need to fill the buffers first
-    if (bf->fill_count < 3) {
-        bf->processed_buf[0] = in;
-        bf->fill_count++;
-        return 0;
-    }
+    bf_lcf_coeffs(freq, Q, rate, bf);
+    return bf_process(in, bf);
+}
+
+
+/**
+* Processes a frame using a high cut filter.
+* \param in     Input sample
+* \param freq   Filter cut off frequency
+* \param Q      Filter quality
+* \param rate   Current sampling rate
+* \param bf     Pointer to the BollieFilter object
+* \return       Output sample
+*/
+float bf_hcf(const float in, const float freq, const float Q, 
+    double rate, BollieFilter* bf) {
 
-    return bf->processed_buf[0] =             
-            (bf->b0 / bf->a0 * bf->in_buf[0]) +
-            (bf->b1 / bf->a0 * bf->in_buf[1]) +
-            (bf->b2 / bf->a0 * bf->in_buf[2]) -
-            (bf->a1 / bf->a0 * bf->processed_buf[1]) -
-            (bf->a2 / bf->a0 * bf->processed_buf[2]);
+    bf_hcf_coeffs(freq, Q, rate, bf);
+    return bf_process(in, bf);
 }
 
+
+/**
+* Bounds how far the outputs of two filters with the same coefficients can
+* still drift apart, if both get the same input from now on. Their
+* difference then follows e[n] = c1 * e[n-1] + c2 * e[n-2]. With the poles
+* p and q it is a sum of p^k * q^(n-k) times the current differences, which
+* neither exceeds 2 / |p - q| nor 1 / (1 - max(|p|, |q|)). Rounding isn't
+* covered, with poles close to 1 it keeps adding differences of its own.
+* \param a      Pointer to the first BollieFilter object
+* \param b      Pointer to the second BollieFilter object
+* \return       Upper bound of the difference of all future outputs,
+*               INFINITY if the buffered inputs differ
+*/
+float bf_divergence(const BollieFilter* a, const BollieFilter* b) {
+    if (a->fill_count != b->fill_count)
+        return INFINITY;
+    for (unsigned int i = 0 ; i < 3 ; ++i)
+        if (a->in_buf[i] != b->in_buf[i])
+            return INFINITY;
+
+    const float e = fabsf(a->processed_buf[0] - b->processed_buf[0]) +
+        fabsf(a->processed_buf[1] - b->processed_buf[1]);
+    if (e == 0)
+        return 0;
+
+    const float c1 = -a->a1 / a->a0;
+    const float c2 = -a->a2 / a->a0;
+    const float disc = c1 * c1 + 4 * c2;
+    const float dist = sqrtf(fabsf(disc));
+    const float radius = disc < 0 ? sqrtf(-c2) : 0.5f * (fabsf(c1) + dist);
+
+    float gain = radius < 1 ? 1 / (1 - radius) : INFINITY;
+    if (dist > 0 && 2 / dist < gain)
+        gain = 2 / dist;
+    return gain * e;
+}
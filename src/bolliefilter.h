@@ -49,11 +49,52 @@ typedef struct bfilter {
 
 void bf_init(BollieFilter*);
 void bf_reset(BollieFilter*); 
+void bf_lcf_coeffs(const float freq, const float Q, double rate,
+    BollieFilter* bf);
+
+void bf_hcf_coeffs(const float freq, const float Q, double rate,
+    BollieFilter* bf);
+
 float bf_lcf(const float in, const float freq, const float Q, 
     double rate, BollieFilter* bf); 
 
 float bf_hcf(const float in, const float freq, const float Q, 
     double rate, BollieFilter* bf); 
+
+float bf_divergence(const BollieFilter* a, const BollieFilter* b);
     
 
+/**
+* Processes a frame using the coefficients set up by bf_lcf_coeffs() or
+* bf_hcf_coeffs(). Lives in the header so block kernels can inline it.
+* \param in     Input sample
+* \param bf     Pointer to the BollieFilter object
+* \return      Output sample
+*/
+static inline __attribute__((always_inline)) float bf_process(const float in,
+    BollieFilter* bf) {
+    // Filter roll
+    bf->in_buf[2] = bf->in_buf[1];
+    bf->in_buf[1] = bf->in_buf[0];
+    bf->in_buf[0] = in;
+
+    bf->processed_buf[2] = bf->processed_buf[1];
+    bf->processed_buf[1] = bf->processed_buf[0];
+
+    // See if we need to fill the buffers first
+    if (bf->fill_count < 3) {
+        bf->processed_buf[0] = in;
+        bf->fill_count++;
+        return 0;
+    }
+
+    return bf->processed_buf[0] =             
+            (bf->b0 / bf->a0 * bf->in_buf[0]) +
+            (bf->b1 / bf->a0 * bf->in_buf[1]) +
+            (bf->b2 / bf->a0 * bf->in_buf[2]) -
+            (bf->a1 / bf->a0 * bf->processed_buf[1]) -
+            (bf->a2 / bf->a0 * bf->processed_buf[2]);
+}
+
+
 #endif
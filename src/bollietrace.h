@@ -0,0 +1,57 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file bollietrace.h
+* \author Bollie
+* \date 19 Oct 2026
+* \brief Optional USDT trace points for profiling the processing path.
+*
+* Build with TRACE=true to get SDT probes (provider "bolliedelay"), which
+* perf and bpftrace can attach to without rebuilding the host, e.g.:
+*
+*     perf buildid-cache --add bolliedelay.so
+*     perf record -e 'sdt_bolliedelay:*' <host>
+*     bpftrace -e 'usdt:./bolliedelay.so:bolliedelay:tape_begin { ... }'
+*
+* Probes:
+* - params_begin(n_samples), params_end: port reading and gain laws
+* - filter_begin(n_frames), filter_end: LCF/HCF pass over one chunk
+* - tape_begin(n_frames, state), tape_end: tape read/write, fades and mix
+* - state(old, new): state machine transitions, s. BollieState
+*
+* Without TRACE=true all of these compile to nothing. With it, every probe
+* is a single nop until a tracer attaches.
+*/
+
+#ifndef __BOLLIETRACE_H__
+#define __BOLLIETRACE_H__
+
+#ifdef BDL_TRACING
+#include <sys/sdt.h>
+#define BDL_TRACE(name) DTRACE_PROBE(bolliedelay, name)
+#define BDL_TRACE1(name, a) DTRACE_PROBE1(bolliedelay, name, a)
+#define BDL_TRACE2(name, a, b) DTRACE_PROBE2(bolliedelay, name, a, b)
+#else
+#define BDL_TRACE(name) do {} while (0)
+#define BDL_TRACE1(name, a) do {} while (0)
+#define BDL_TRACE2(name, a, b) do {} while (0)
+#endif
+
+#endif
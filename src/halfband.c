@@ -0,0 +1,70 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file halfband.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief Polyphase halfband filters for 2:1 decimation and 1:2 interpolation.
+*/
+
+#include "halfband.h"
+#include <math.h>
+
+
+/**
+* Clears the state of a Halfband object.
+* \param hb Pointer to a Halfband object.
+*/
+void hb_reset(Halfband* hb) {
+    for (unsigned int i = 0 ; i < HB_COEFFS ; ++i) {
+        hb->x[i] = 0;
+        hb->y[i] = 0;
+    }
+    hb->in = 0;
+    hb->phase = 0;
+}
+
+
+/**
+* Bounds how far the outputs of two halfbands can still drift apart, if both
+* get the same input from now on. A first order allpass passes on its
+* difference of x[i] + coeff * y[i] once and lets it decay by the
+* coefficient, while the differences coming from the previous allpass are
+* amplified by at most the sum of its impulse response, 1 + 2 * coeff.
+* \param a      Pointer to the first Halfband object
+* \param b      Pointer to the second Halfband object
+* \return       Upper bound of the difference of all future outputs,
+*               INFINITY if the phases differ
+*/
+float hb_divergence(const Halfband* a, const Halfband* b) {
+    if (a->phase != b->phase)
+        return INFINITY;
+
+    float path[2] = { 0, 0 };
+    for (unsigned int i = 0 ; i < HB_COEFFS ; ++i) {
+        path[i & 1] = path[i & 1] * (1 + 2 * hb_coeffs[i]) +
+            fabsf(a->x[i] - b->x[i]) + hb_coeffs[i] * fabsf(a->y[i] - b->y[i]);
+    }
+
+    // A held input has yet to run through the second path
+    if (a->phase)
+        path[1] += HB_GAIN * fabsf(a->in - b->in);
+    return path[0] + path[1];
+}
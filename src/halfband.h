@@ -0,0 +1,134 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file halfband.h
+* \author Bollie
+* \date 19 Oct 2026
+* \brief Polyphase halfband filters for 2:1 decimation and 1:2 interpolation.
+*
+* Two paths of first order allpasses running at the lower rate (elliptic
+* halfband, 9th order). Stopband below -70 dB from 0.3 fs, passband flat up
+* to 0.2 fs, group delay about 2.3 samples at the higher rate below 0.05 fs.
+*/
+
+#ifndef __HALFBAND_H__
+#define __HALFBAND_H__
+
+#define HB_COEFFS 4     ///< allpass coefficients, alternating between paths
+#define HB_GAIN 4.2f    ///< max. sum of the impulse response of either path
+
+/**
+* Allpass coefficients, even indices belong to the path of the newer
+* sample, odd ones to the path of the older one.
+*/
+static const float hb_coeffs[HB_COEFFS] = {
+    7.9866426236e-02f,
+    2.8382934487e-01f,
+    5.4532365107e-01f,
+    8.3441189148e-01f,
+};
+
+
+/**
+* Halfband state, used for decimation as well as interpolation
+*/
+typedef struct halfband {
+    float x[HB_COEFFS];     ///< previous allpass inputs
+    float y[HB_COEFFS];     ///< previous allpass outputs
+    float in;               ///< held input sample while decimating
+    unsigned int phase;     ///< 1, if the next input yields an output
+} Halfband;
+
+
+void hb_reset(Halfband* hb);
+float hb_divergence(const Halfband* a, const Halfband* b);
+
+
+/**
+* Runs both allpass paths for one sample at the lower rate.
+* \param hb     Pointer to the Halfband object
+* \param s0     In/out: sample of the first path
+* \param s1     In/out: sample of the second path
+*/
+static inline __attribute__((always_inline)) void hb_paths(Halfband* hb,
+    float* s0, float* s1) {
+    float a = *s0;
+    float b = *s1;
+    for (unsigned int i = 0 ; i < HB_COEFFS ; i += 2) {
+        const float ya = (a - hb->y[i]) * hb_coeffs[i] + hb->x[i];
+        const float yb = (b - hb->y[i+1]) * hb_coeffs[i+1] + hb->x[i+1];
+        hb->x[i] = a;
+        hb->x[i+1] = b;
+        hb->y[i] = a = ya;
+        hb->y[i+1] = b = yb;
+    }
+    *s0 = a;
+    *s1 = b;
+}
+
+
+/**
+* Feeds one sample into the decimator. Every second call yields an output.
+* \param hb     Pointer to the Halfband object
+* \param x      In: input sample, out: output sample if 1 is returned
+* \return       1 if x holds a new output sample at half the rate
+*/
+static inline __attribute__((always_inline)) int hb_decimate(Halfband* hb,
+    float* x) {
+    hb->phase ^= 1;
+    if (hb->phase) {
+        hb->in = *x;
+        return 0;
+    }
+
+    float s0 = *x;
+    float s1 = hb->in;
+    hb_paths(hb, &s0, &s1);
+    *x = 0.5f * (s0 + s1);
+    return 1;
+}
+
+
+/**
+* Advances the decimator like hb_decimate() without filtering, keeping its
+* phase while the input is ignored.
+* \param hb     Pointer to the Halfband object
+* \return       1 where hb_decimate() would yield an output sample
+*/
+static inline __attribute__((always_inline)) int hb_skip(Halfband* hb) {
+    hb->phase ^= 1;
+    return !hb->phase;
+}
+
+
+/**
+* Feeds one sample into the interpolator, yielding two at double the rate.
+* \param hb     Pointer to the Halfband object
+* \param x      Input sample
+* \param out    Output samples, in order
+*/
+static inline __attribute__((always_inline)) void hb_interpolate(
+    Halfband* hb, const float x, float out[2]) {
+    out[0] = x;
+    out[1] = x;
+    hb_paths(hb, &out[0], &out[1]);
+}
+
+#endif
@@ -0,0 +1,169 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file bench.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief Measures the cost of run() for every kernel variant.
+*
+* Usage: bench [plugin binary] [sample rate] [isa] [tape]
+*
+* The optional isa (sse2, avx2, avx512) and tape (full, half, quarter)
+* restrict the run to those variants, e.g. to look at one of them through
+* perf stat.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "plughost.h"
+
+#define BLOCK 128
+#define SECONDS 10
+
+
+/**
+* Current time in nanoseconds
+*/
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/**
+* Benchmarks one variant.
+* \param path   plugin binary
+* \param rate   sample rate
+* \param low    LCF enabled
+* \param high   HCF enabled
+* \param steady measure steady state instead of constant tempo changes
+* \param quality tape rate, 0=full, 1=half, 2=quarter
+* \param mono   feed the same signal into both inputs
+* \param frozen measure with the freeze engaged
+* \return ns per sample, negative on error
+*/
+static double bench_variant(const char* path, double rate, int low, int high,
+    int steady, int quality, int mono, int frozen) {
+
+    PlugHost ph;
+    unsigned int seed = 1;
+    if (ph_open(&ph, path, rate, BLOCK))
+        return -1;
+
+    ph.ctl[PH_TEMPO_MODE] = 1;
+    ph.ctl[PH_LOW_ON] = low;
+    ph.ctl[PH_LOW_F] = 120;
+    ph.ctl[PH_HIGH_ON] = high;
+    ph.ctl[PH_HIGH_F] = 6000;
+    ph.ctl[PH_QUALITY] = quality;
+
+    // Warm up until the tape is filled and faded in (and frozen)
+    uint32_t blocks = rate * 2 / BLOCK;
+    for (uint32_t b = 0 ; b < blocks ; ++b) {
+        ph.ctl[PH_FREEZE] = (frozen && b >= blocks / 2);
+        ph_noise(&ph, BLOCK, &seed);
+        if (mono)
+            memcpy(ph.in_r, ph.in_l, BLOCK * sizeof(float));
+        ph_run(&ph, BLOCK);
+    }
+
+    double total = 0;
+    uint32_t change = rate / 4 / BLOCK;
+    blocks = rate * SECONDS / BLOCK;
+    for (uint32_t b = 0 ; b < blocks ; ++b) {
+        // Keep the plugin busy with fades and filling the tape
+        if (!steady && b % change == 0)
+            ph.ctl[PH_TEMPO_USER] = (ph.ctl[PH_TEMPO_USER] == 120 ? 121 : 120);
+
+        ph_noise(&ph, BLOCK, &seed);
+        if (mono)
+            memcpy(ph.in_r, ph.in_l, BLOCK * sizeof(float));
+        double start = now_ns();
+        ph_run(&ph, BLOCK);
+        total += now_ns() - start;
+    }
+
+    ph_close(&ph);
+    return total / ((double)blocks * BLOCK);
+}
+
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "build/bolliedelay.lv2/bolliedelay.so";
+    double rate = argc > 2 ? atof(argv[2]) : 48000;
+    const char* only_isa = argc > 3 ? argv[3] : NULL;
+    const char* only_tape = argc > 4 ? argv[4] : NULL;
+    const char* isas[] = { "sse2", "avx2", "avx512" };
+    const char* tapes[] = { "full", "half", "quarter" };
+
+    printf("%-8s %-8s %-6s %-4s %-4s %-10s %10s\n", "isa", "tape", "input",
+        "low", "high", "state", "ns/sample");
+
+    for (unsigned int i = 0 ; i < sizeof(isas) / sizeof(isas[0]) ; ++i) {
+        if (only_isa && strcmp(only_isa, isas[i]) != 0)
+            continue;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        // Has to match select_kernels() in bolliedelay.c
+        __builtin_cpu_init();
+        if ((i == 1 && !(__builtin_cpu_supports("avx2") &&
+                __builtin_cpu_supports("fma"))) ||
+            (i == 2 && !(__builtin_cpu_supports("avx512f") &&
+                __builtin_cpu_supports("avx512vl")))) {
+            printf("%-8s not supported by this CPU\n", isas[i]);
+            continue;
+        }
+#else
+        if (i > 0)
+            continue;
+#endif
+        setenv("BOLLIEDELAY_ISA", isas[i], 1);
+        for (int q = 0 ; q < 3 ; ++q) {
+            if (only_tape && strcmp(only_tape, tapes[q]) != 0)
+                continue;
+            for (int mono = 0 ; mono < 2 ; ++mono) {
+                // Mono only matters once the tape is cycling
+                for (int steady = 1 ; steady >= mono ; --steady) {
+                    for (int v = 0 ; v < 4 ; ++v) {
+                        double ns = bench_variant(path, rate, (v & 1) != 0,
+                            (v & 2) != 0, steady, q, mono, 0);
+                        if (ns < 0)
+                            return 1;
+                        printf("%-8s %-8s %-6s %-4s %-4s %-10s %10.2f\n",
+                            isas[i], tapes[q], mono ? "mono" : "stereo",
+                            v & 1 ? "on" : "off", v & 2 ? "on" : "off",
+                            steady ? "cycle" : "transition", ns);
+                    }
+                }
+
+                // Frozen, the filters are left alone anyway
+                double ns = bench_variant(path, rate, 1, 1, 1, q, mono, 1);
+                if (ns < 0)
+                    return 1;
+                printf("%-8s %-8s %-6s %-4s %-4s %-10s %10.2f\n", isas[i],
+                    tapes[q], mono ? "mono" : "stereo", "on", "on", "frozen",
+                    ns);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file enginecheck.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief Checks the shortcuts of the delay engine against the plain way.
+*
+* Usage: enginecheck [mono|freeze]
+*
+* mono runs an instance, that may switch to the mono kernels, next to one
+* kept in stereo by BOLLIEDELAY_MONO=0. Both get stereo noise, then the same
+* noise on both sides, then stereo again and so on. Their outputs have to
+* match, whatever filters, feedback and tape rate are set.
+*
+* freeze plays CLICKS clicks per delay time, freezes the repeats and lets
+* them go again in the middle of the loop. While frozen the output has to repeat
+* exactly, all along every click has to stay in its place and there must be
+* nothing else. A delay longer than half the tape can't be frozen, it has to
+* carry on fading instead. Exits non-zero, if any check fails.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "bolliedelay.h"
+
+#define BLOCK 256
+
+/* Rounding alone keeps the LCF at 200 Hz and 96 kHz from playing the same in
+two differently compiled kernels, the SSE2 and AVX-512 stereo kernels differ
+by up to 2e-4 there. Mono starting too early, while the right side still
+differed, showed differences from 4e-3 up. */
+#define MAX_DIFF 1e-3f      ///< Allowed difference to the stereo kernels
+#define CLICKS 8            ///< Clicks per delay time
+#define CLICK_POS 1000      ///< Position of the clicks within their spacing
+#define CLICK_WIDTH 256     ///< Frames around a click the resamplers ring
+#define MAX_LOOP_DIFF 1e-6f ///< Allowed difference between the loop's rounds
+#define MAX_STRAY 1e-3f     ///< Allowed output between the clicks
+
+
+/**
+* Parameters of a mono check
+*/
+typedef struct {
+    const char* name;
+    double rate;
+    int div;            ///< divider of both sides, s. BD_DIV_L
+    float feedback;
+    float crossf;
+    int low_on;
+    float low_f;
+    float low_q;
+    int high_on;
+    float high_f;
+    int quality;        ///< tape rate
+} MonoCase;
+
+static const MonoCase mono_cases[] = {
+    { "1/16, no feedback", 48000, 5, 0, 0, 0, 20, 1, 0, 7500, 0 },
+    { "LCF 20 Hz, Q 8", 48000, 0, 40, 20, 1, 20, 8, 0, 7500, 0 },
+    { "LCF 20 Hz, Q 8", 192000, 0, 40, 20, 1, 20, 8, 0, 7500, 0 },
+    { "LCF 200 Hz, Q 0.5", 96000, 2, 80, 30, 1, 200, 0.5f, 0, 7500, 0 },
+    { "tape 1/2", 48000, 0, 40, 20, 0, 20, 1, 0, 7500, 1 },
+    { "tape 1/4, HCF", 48000, 3, 60, 10, 0, 20, 1, 1, 2000, 2 },
+};
+
+#define N_MONO_CASES (sizeof(mono_cases) / sizeof(mono_cases[0]))
+
+/**
+* Seconds of input per section, even sections are stereo, odd ones mono
+*/
+static const double sections[] = { 1, 6, 0.5, 6 };
+
+#define N_SECTIONS (sizeof(sections) / sizeof(sections[0]))
+
+
+/**
+* Creates an instance for a mono check.
+* \param c      parameters
+* \param mono   0 to keep the instance in stereo
+* \return instance, free() it when done
+*/
+static BollieDelay* mono_instance(const MonoCase* c, int mono) {
+    // Read by bd_create()
+    if (mono)
+        unsetenv("BOLLIEDELAY_MONO");
+    else
+        setenv("BOLLIEDELAY_MONO", "0", 1);
+
+    BollieDelay* bd = bd_create(malloc(bd_size()), c->rate);
+    unsetenv("BOLLIEDELAY_MONO");
+    bd_reset(bd);
+
+    bd_set_param(bd, BD_TEMPO_MODE, 1);
+    bd_set_param(bd, BD_MIX, 100);
+    bd_set_param(bd, BD_DIV_L, c->div);
+    bd_set_param(bd, BD_DIV_R, c->div);
+    bd_set_param(bd, BD_FEEDBACK, c->feedback);
+    bd_set_param(bd, BD_CROSSF, c->crossf);
+    bd_set_param(bd, BD_LOW_ON, c->low_on);
+    bd_set_param(bd, BD_LOW_F, c->low_f);
+    bd_set_param(bd, BD_LOW_Q, c->low_q);
+    bd_set_param(bd, BD_HIGH_ON, c->high_on);
+    bd_set_param(bd, BD_HIGH_F, c->high_f);
+    bd_set_param(bd, BD_QUALITY, c->quality);
+    return bd;
+}
+
+
+/**
+* Compares an instance, that may go mono, with one kept in stereo.
+* \param c  parameters
+* \return 0 if the outputs match
+*/
+static int check_mono(const MonoCase* c) {
+    BollieDelay* a = mono_instance(c, 1);
+    BollieDelay* b = mono_instance(c, 0);
+    float in_l[BLOCK], in_r[BLOCK];
+    float a_l[BLOCK], a_r[BLOCK], b_l[BLOCK], b_r[BLOCK];
+    unsigned int seed = 1;
+    float max_diff = 0;
+    float max_out = 0;
+    long blocks = 0;
+    long same = 0;
+
+    for (unsigned int s = 0 ; s < N_SECTIONS ; ++s) {
+        const long n = sections[s] * c->rate / BLOCK;
+        for (long k = 0 ; k < n ; ++k, ++blocks) {
+            for (int i = 0 ; i < BLOCK ; ++i) {
+                in_l[i] = rand_r(&seed) * (2.0f / RAND_MAX) - 1;
+                in_r[i] = (s & 1) ? in_l[i] :
+                    rand_r(&seed) * (2.0f / RAND_MAX) - 1;
+            }
+            bd_process(a, in_l, in_r, a_l, a_r, BLOCK);
+            bd_process(b, in_l, in_r, b_l, b_r, BLOCK);
+
+            for (int i = 0 ; i < BLOCK ; ++i) {
+                max_diff = fmaxf(max_diff, fabsf(a_l[i] - b_l[i]));
+                max_diff = fmaxf(max_diff, fabsf(a_r[i] - b_r[i]));
+                max_out = fmaxf(max_out, fabsf(b_r[i]));
+            }
+            same += (memcmp(a_l, a_r, sizeof(a_l)) == 0);
+        }
+    }
+    // Silence would match as well
+    int failed = (max_diff > MAX_DIFF || max_out < 0.1f);
+
+    printf("%-6s %-20s %6.0fHz: L = R in %4.1f%% of the blocks, "
+        "max. difference %.2g %s\n", "mono", c->name, c->rate,
+        100.0 * same / blocks, max_diff, failed ? "FAIL" : "ok");
+    free(a);
+    free(b);
+    return failed;
+}
+
+
+/**
+* Parameters of a freeze check, the delay is 1/4
+*/
+typedef struct {
+    double rate;
+    float tempo;        ///< BPM
+    int quality;        ///< tape rate
+    int frozen;         ///< 0 if the freeze has to be refused
+} FreezeCase;
+
+static const FreezeCase freeze_cases[] = {
+    { 48000, 120, 0, 1 },
+    { 48000, 120, 1, 1 },
+    { 48000, 120, 2, 1 },
+    { 192000, 12, 0, 1 },
+    { 192000, 6, 0, 0 },
+};
+
+#define N_FREEZE_CASES (sizeof(freeze_cases) / sizeof(freeze_cases[0]))
+
+
+/**
+* Freezes the repeats of a click train for 3.3 delay times and lets them go.
+* Repeats read from the wrong place of the tape would show up between the
+* clicks.
+* \param c  parameters
+* \return 0 if the repeats stay in place and the freeze loops exactly
+*/
+static int check_freeze(const FreezeCase* c) {
+    BollieDelay* bd = bd_create(malloc(bd_size()), c->rate);
+    bd_reset(bd);
+    bd_set_param(bd, BD_TEMPO_MODE, 1);
+    bd_set_param(bd, BD_TEMPO_USER, c->tempo);
+    bd_set_param(bd, BD_MIX, 100);
+    bd_set_param(bd, BD_FEEDBACK, 80);
+    bd_set_param(bd, BD_CROSSF, 0);
+    bd_set_param(bd, BD_QUALITY, c->quality);
+
+    const long d = lround(c->rate * 60 / c->tempo);
+    const long spacing = d / CLICKS;
+    const long on = 3 * d / BLOCK * BLOCK;
+    const long off = (on + 33 * d / 10) / BLOCK * BLOCK;
+    const long end = off + 4 * d;
+
+    // One delay time of output, to compare the loop's rounds
+    float* last = calloc(d, sizeof(float));
+    float in_l[BLOCK], in_r[BLOCK], out_l[BLOCK], out_r[BLOCK];
+    long click = -1;        // position of the repeats within their spacing
+    float peak = 0;         // of the current repeat
+    int missing = 0;        // repeats not where they should be
+    float stray = 0;
+    float loop_diff = 0;
+    float min_peak = 1;
+
+    for (long n = 0 ; n < end ; n += BLOCK) {
+        for (int i = 0 ; i < BLOCK ; ++i)
+            in_l[i] = in_r[i] = 
+                (n + i < on && (n + i) % spacing == CLICK_POS);
+        bd_set_param(bd, BD_FREEZE, n >= on && n < off);
+        bd_process(bd, in_l, in_r, out_l, out_r, BLOCK);
+
+        for (int i = 0 ; i < BLOCK ; ++i) {
+            const long m = n + i;
+            const long pos = m % spacing;
+            const float out = fmaxf(fabsf(out_l[i]), fabsf(out_r[i]));
+
+            // Frozen from the second round of the loop on
+            if (m >= on + 2 * d && m < off)
+                loop_diff = fmaxf(loop_diff, fabsf(out_l[i] - last[m % d]));
+            last[m % d] = out_l[i];
+
+            // The first repeats show, where the others have to be
+            if (m >= d && click < 0 && out > 0.05f)
+                click = pos;
+            if (click >= 0 && labs(pos - click) > CLICK_WIDTH)
+                stray = fmaxf(stray, out);
+            if (click >= 0 && pos == click)
+                peak = out;
+
+            // Every spacing after the first repeats must have one
+            if (pos == spacing - 1 && m >= 2 * d) {
+                missing += (peak < 1e-3f);
+                min_peak = fminf(min_peak, peak);
+                peak = 0;
+            }
+        }
+    }
+
+    int failed = (click < 0 || missing > 0 || stray > MAX_STRAY);
+    if (c->frozen)
+        failed |= (loop_diff > MAX_LOOP_DIFF);
+    else
+        failed |= (loop_diff < 0.1f);
+
+    printf("%-6s %6.0fHz %3.0f BPM tape %d: %s, loop difference %.2g, "
+        "repeats %ld, min. %.2g, stray %.2g %s\n", "freeze", c->rate,
+        c->tempo, c->quality, c->frozen ? "frozen" : "refused", loop_diff,
+        click, min_peak, stray, failed ? "FAIL" : "ok");
+    free(last);
+    free(bd);
+    return failed;
+}
+
+
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : NULL;
+    int failed = 0;
+
+    if (!only || strcmp(only, "mono") == 0)
+        for (unsigned int i = 0 ; i < N_MONO_CASES ; ++i)
+            failed |= check_mono(&mono_cases[i]);
+    if (!only || strcmp(only, "freeze") == 0)
+        for (unsigned int i = 0 ; i < N_FREEZE_CASES ; ++i)
+            failed |= check_freeze(&freeze_cases[i]);
+    return failed ? 1 : 0;
+}
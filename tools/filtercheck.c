@@ -0,0 +1,407 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file filtercheck.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief Measures cost and accuracy of the BollieFilter kernels.
+*
+* Usage: filtercheck [bench|accuracy|stability]
+*
+* bench prints ns/sample with static parameters, parameters swept once per
+* block (like the delay does) and swept every sample. accuracy compares the
+* magnitude response against the analytic double precision response of the
+* same filter, both from the coefficients and from a sine run through the
+* filter, over the frequency and Q ranges of bolliedelay.ttl. stability
+* looks at the pole radius and runs noise through the filter at the edges
+* of those ranges. Exits non-zero, if any limit below is exceeded.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "bolliefilter.h"
+
+#define BLOCK 128
+#define BENCH_SAMPLES (1 << 22)
+#define N_FREQS 25              ///< Cut off frequencies per kernel and rate
+#define N_QS 13                 ///< Q values, half octaves from 0.125 to 8
+
+/* Limits of the float biquad as it is. The worst case is the LCF at 20 Hz
+and 96 kHz, where the poles sit that close to 1, that rounding the
+coefficients to float moves the response by about 1 dB. */
+#define MAX_COEFF_DB 1.5        ///< Allowed error of the coefficients
+#define MAX_SINE_DB 1.5         ///< Allowed error of the processed sine
+
+/**
+* A filter kernel with its parameter range
+*/
+typedef struct {
+    const char* name;
+    float (*sample)(const float, const float, const float, double,
+        BollieFilter*);
+    void (*coeffs)(const float, const float, double, BollieFilter*);
+    int high;           ///< 1 for a high cut, 0 for a low cut
+    float f_min;        ///< lowest cut off frequency in bolliedelay.ttl
+    float f_max;        ///< highest cut off frequency in bolliedelay.ttl
+} Kernel;
+
+static const Kernel kernels[] = {
+    { "lcf", bf_lcf, bf_lcf_coeffs, 0, 20, 2000 },
+    { "hcf", bf_hcf, bf_hcf_coeffs, 1, 200, 22000 },
+};
+
+#define N_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+static const double rates[] = { 44100, 48000, 96000 };
+
+#define N_RATES (sizeof(rates) / sizeof(rates[0]))
+
+
+/**
+* Current time in nanoseconds
+*/
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+/**
+* Cut off frequency number i of N_FREQS, logarithmically spaced
+*/
+static float freq_at(const Kernel* k, int i) {
+    return k->f_min * pow(k->f_max / k->f_min, i / (double)(N_FREQS - 1));
+}
+
+
+/**
+* Q number i of N_QS
+*/
+static float q_at(int i) {
+    return pow(2, (i - 6) * 0.5);
+}
+
+
+/**
+* Analytic magnitude of a biquad.
+* \param b  numerator coefficients
+* \param a  denominator coefficients
+* \param w  angular frequency in radians per sample
+* \return |H(e^jw)|
+*/
+static double biquad_mag(const double b[3], const double a[3], double w) {
+    double br = b[0] + b[1] * cos(w) + b[2] * cos(2 * w);
+    double bi = -b[1] * sin(w) - b[2] * sin(2 * w);
+    double ar = a[0] + a[1] * cos(w) + a[2] * cos(2 * w);
+    double ai = -a[1] * sin(w) - a[2] * sin(2 * w);
+    return sqrt((br * br + bi * bi) / (ar * ar + ai * ai));
+}
+
+
+/**
+* Coefficients of the filter in double precision, the same formulas as
+* bolliefilter.c.
+* \param high 1 for a high cut
+* \param pi   value of pi to use
+*/
+static void ref_coeffs(int high, double freq, double Q, double rate,
+    double pi, double b[3], double a[3]) {
+
+    double w0 = 2 * pi * freq / rate;
+    double alpha = sin(w0) / (2 * Q);
+    double c = high ? -cos(w0) : cos(w0);
+    a[0] = 1 + alpha;
+    a[1] = -2 * cos(w0);
+    a[2] = 1 - alpha;
+    b[0] = (1 + c) / 2;
+    b[1] = high ? 1 + c : -(1 + c);
+    b[2] = (1 + c) / 2;
+}
+
+
+/**
+* Magnitude error in dB, guarding against silence
+*/
+static double err_db(double mag, double ref) {
+    return fabs(20 * log10((mag + 1e-12) / (ref + 1e-12)));
+}
+
+
+/**
+* Benchmarks a kernel.
+* \param k     kernel
+* \param mode  0: static, 1: swept per block, 2: swept per sample
+* \param block 1 to set the coefficients per block and use bf_process()
+* \return ns per sample
+*/
+static double bench_kernel(const Kernel* k, int mode, int block) {
+    static float buf[BLOCK];
+    BollieFilter bf;
+    unsigned int seed = 1;
+    float sink = 0;
+    double total = 0;
+    const float f_mid = sqrt(k->f_min * k->f_max);
+
+    bf_init(&bf);
+    bf.rate = 0;
+    for (int n = 0 ; n < BENCH_SAMPLES ; n += BLOCK) {
+        for (int i = 0 ; i < BLOCK ; ++i) {
+            seed = seed * 1664525 + 1013904223;
+            buf[i] = (int32_t)seed * (1.0f / 2147483648.0f);
+        }
+
+        float freq = f_mid;
+        if (mode == 1)
+            freq = f_mid * (1 + 0.5f * ((n / BLOCK) & 1));
+
+        double start = now_ns();
+        if (block) {
+            k->coeffs(freq, 0.7f, 48000, &bf);
+            for (int i = 0 ; i < BLOCK ; ++i)
+                buf[i] = bf_process(buf[i], &bf);
+        }
+        else if (mode == 2) {
+            for (int i = 0 ; i < BLOCK ; ++i)
+                buf[i] = k->sample(buf[i], freq + (i & 1), 0.7f, 48000, &bf);
+        }
+        else {
+            for (int i = 0 ; i < BLOCK ; ++i)
+                buf[i] = k->sample(buf[i], freq, 0.7f, 48000, &bf);
+        }
+        total += now_ns() - start;
+        sink += buf[BLOCK - 1];
+    }
+
+    // Keep the compiler from dropping the loops
+    if (sink == 12345.f)
+        printf(" ");
+    return total / BENCH_SAMPLES;
+}
+
+
+/**
+* Prints ns/sample of every kernel for static and swept parameters.
+*/
+static void bench() {
+    const char* modes[] = { "static", "per block", "per sample" };
+
+    printf("%-6s %-12s %-11s %10s\n", "kernel", "call", "parameters",
+        "ns/sample");
+    for (unsigned int k = 0 ; k < N_KERNELS ; ++k) {
+        for (int mode = 0 ; mode < 3 ; ++mode) {
+            for (int block = 0 ; block < 2 ; ++block) {
+                // Per sample sweeps only exist for the per sample call
+                if (block && mode == 2)
+                    continue;
+                printf("%-6s %-12s %-11s %10.2f\n", kernels[k].name,
+                    block ? "bf_process" : kernels[k].name, modes[mode],
+                    bench_kernel(&kernels[k], mode, block));
+            }
+        }
+    }
+    printf("\n");
+}
+
+
+/**
+* Runs a sine through a kernel and measures its amplitude after settling.
+* \param k    kernel
+* \param freq cut off frequency
+* \param Q    quality
+* \param rate sample rate
+* \param f    frequency of the sine
+* \return amplitude of the output
+*/
+static double sine_mag(const Kernel* k, float freq, float Q, double rate,
+    double f) {
+
+    BollieFilter bf;
+    bf_init(&bf);
+    bf.rate = 0;
+
+    // The slowest decay is about 2Q/w0 seconds, give it 20 of these
+    const double w = 2 * M_PI * f / rate;
+    const double w0 = 2 * M_PI * freq / rate;
+    long settle = 40 * Q / fmin(w0, M_PI - w0) + 1000;
+    long periods = ceil(rate * 0.25 / (rate / f));
+    long n = lround(periods * rate / f);
+
+    double re = 0, im = 0;
+    for (long i = 0 ; i < settle + n ; ++i) {
+        float y = k->sample(sin(w * i), freq, Q, rate, &bf);
+        if (i >= settle) {
+            re += y * sin(w * i);
+            im += y * cos(w * i);
+        }
+    }
+    return 2 * sqrt(re * re + im * im) / n;
+}
+
+
+/**
+* Checks the magnitude response of every kernel against the analytic double
+* precision response of the same design.
+* \return number of failures
+*/
+static int accuracy() {
+    int failures = 0;
+    const double probes[] = { 0.25, 0.5, 1, 2, 4 };
+
+    // PI 3.141592 only scales every cut off frequency
+    printf("PI 3.141592 moves every cut off by %.6f cents\n",
+        1200 * log2(PI / M_PI));
+
+    printf("%-6s %-7s %12s %-18s %12s %-18s %12s %-18s\n", "kernel", "rate",
+        "PI dB", "(f, Q)", "coeffs dB", "(f, Q)", "sine dB", "(f, Q)");
+    for (unsigned int k = 0 ; k < N_KERNELS ; ++k) {
+        const Kernel* kn = &kernels[k];
+        for (unsigned int r = 0 ; r < N_RATES ; ++r) {
+            const double rate = rates[r];
+            double worst[3] = { 0, 0, 0 };
+            float where[3][2] = { { 0 } };
+
+            for (int fi = 0 ; fi < N_FREQS ; ++fi) {
+                for (int qi = 0 ; qi < N_QS ; ++qi) {
+                    const float freq = freq_at(kn, fi);
+                    const float Q = q_at(qi);
+                    double b[3], a[3], bp[3], ap[3], bf32[3], af32[3];
+                    ref_coeffs(kn->high, freq, Q, rate, M_PI, b, a);
+                    ref_coeffs(kn->high, freq, Q, rate, PI, bp, ap);
+
+                    BollieFilter bf;
+                    bf_init(&bf);
+                    kn->coeffs(freq, Q, rate, &bf);
+                    bf32[0] = bf.b0; bf32[1] = bf.b1; bf32[2] = bf.b2;
+                    af32[0] = bf.a0; af32[1] = bf.a1; af32[2] = bf.a2;
+
+                    double e[3] = { 0, 0, 0 };
+                    for (unsigned int p = 0 ; p < 5 ; ++p) {
+                        const double f = freq * probes[p];
+                        if (f >= rate / 2)
+                            continue;
+                        const double w = 2 * M_PI * f / rate;
+                        const double ref = biquad_mag(b, a, w);
+                        e[0] = fmax(e[0], err_db(biquad_mag(bp, ap, w), ref));
+                        e[1] = fmax(e[1],
+                            err_db(biquad_mag(bf32, af32, w), ref));
+
+                        // Running sines is slow, the cut off has to do
+                        if (probes[p] == 1)
+                            e[2] = err_db(sine_mag(kn, freq, Q, rate, f),
+                                ref);
+                    }
+                    for (int i = 0 ; i < 3 ; ++i) {
+                        if (e[i] > worst[i]) {
+                            worst[i] = e[i];
+                            where[i][0] = freq;
+                            where[i][1] = Q;
+                        }
+                    }
+                }
+            }
+
+            int fail = worst[1] > MAX_COEFF_DB || worst[2] > MAX_SINE_DB;
+            failures += fail;
+            printf("%-6s %-7.0f %12.2e (%7.1f, %5.3f) %12.2e (%7.1f, %5.3f) "
+                "%12.2e (%7.1f, %5.3f)%s\n", kn->name, rate,
+                worst[0], where[0][0], where[0][1],
+                worst[1], where[1][0], where[1][1],
+                worst[2], where[2][0], where[2][1], fail ? " FAIL" : "");
+        }
+    }
+    printf("\n");
+    return failures;
+}
+
+
+/**
+* Checks the poles and the output for noise at the edges of the parameter
+* ranges.
+* \return number of failures
+*/
+static int stability() {
+    int failures = 0;
+
+    printf("%-6s %-7s %8s %6s %12s %12s\n", "kernel", "rate", "f", "Q",
+        "pole radius", "peak out");
+    for (unsigned int k = 0 ; k < N_KERNELS ; ++k) {
+        const Kernel* kn = &kernels[k];
+        for (unsigned int r = 0 ; r < N_RATES ; ++r) {
+            for (int e = 0 ; e < 4 ; ++e) {
+                const double rate = rates[r];
+                const float freq = (e & 1) ? kn->f_max : kn->f_min;
+                const float Q = (e & 2) ? 8 : 0.125f;
+
+                BollieFilter bf;
+                bf_init(&bf);
+                kn->coeffs(freq, Q, rate, &bf);
+
+                // Poles of z^2 + a1/a0 z + a2/a0, as processed in float
+                const double p = (float)(bf.a1 / bf.a0);
+                const double q = (float)(bf.a2 / bf.a0);
+                const double d = p * p - 4 * q;
+                double radius = sqrt(fabs(q));
+                if (d >= 0)
+                    radius = fmax(fabs(-p + sqrt(d)), fabs(-p - sqrt(d))) / 2;
+
+                // Ten seconds of full scale noise after an impulse
+                unsigned int seed = 1;
+                double peak = 0;
+                for (long i = 0 ; i < 10 * rate ; ++i) {
+                    seed = seed * 1664525 + 1013904223;
+                    float in = (i == 0) ? 1 :
+                        (int32_t)seed * (1.0f / 2147483648.0f);
+                    float out = kn->sample(in, freq, Q, rate, &bf);
+                    if (!isfinite(out) || fabs(out) > peak)
+                        peak = isfinite(out) ? fabs(out) : INFINITY;
+                }
+
+                int fail = radius >= 1 || !isfinite(peak);
+                failures += fail;
+                printf("%-6s %-7.0f %8.0f %6.3f %12.9f %12.4f%s\n", kn->name,
+                    rate, freq, Q, radius, peak, fail ? " FAIL" : "");
+            }
+        }
+    }
+    printf("\n");
+    return failures;
+}
+
+
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : NULL;
+    int failures = 0;
+
+    if (!only || strcmp(only, "bench") == 0)
+        bench();
+    if (!only || strcmp(only, "accuracy") == 0)
+        failures += accuracy();
+    if (!only || strcmp(only, "stability") == 0)
+        failures += stability();
+
+    if (failures)
+        printf("%d checks failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file plughost.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief A minimal LV2 host for driving the plugin from the tools.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include "plughost.h"
+
+
+/**
+* Maps a URI to a URID, s. LV2_URID_Map.
+* \param handle Pointer to the PlugHost object
+* \param uri    URI to map
+* \return URID, 0 if the table is full
+*/
+static LV2_URID ph_map(LV2_URID_Map_Handle handle, const char* uri) {
+    PlugHost* ph = (PlugHost*)handle;
+    for (uint32_t i = 0 ; i < ph->n_uris ; ++i) {
+        if (strcmp(ph->uris[i], uri) == 0)
+            return i + 1;
+    }
+    if (ph->n_uris == PH_MAX_URIS)
+        return 0;
+    ph->uris[ph->n_uris] = strdup(uri);
+    return ++ph->n_uris;
+}
+
+
+/**
+* Loads the plugin binary, instantiates and activates it.
+* \param ph        Pointer to the PlugHost object
+* \param path      Path to the plugin binary
+* \param rate      Sample rate
+* \param max_block Maximum number of samples per ph_run() call
+* \return 0 on success
+*/
+int ph_open(PlugHost* ph, const char* path, double rate, uint32_t max_block) {
+    ph->lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!ph->lib) {
+        fprintf(stderr, "Cannot load %s: %s\n", path, dlerror());
+        return 1;
+    }
+
+    const LV2_Descriptor* (*get_desc)(uint32_t) =
+        (const LV2_Descriptor* (*)(uint32_t))dlsym(ph->lib, "lv2_descriptor");
+    if (!get_desc || !(ph->desc = get_desc(0))) {
+        fprintf(stderr, "No descriptor in %s\n", path);
+        dlclose(ph->lib);
+        return 1;
+    }
+
+    ph->rate = rate;
+    ph->max_block = max_block;
+    ph->in_l = calloc(max_block, sizeof(float));
+    ph->in_r = calloc(max_block, sizeof(float));
+    ph->out_l = calloc(max_block, sizeof(float));
+    ph->out_r = calloc(max_block, sizeof(float));
+
+    // The only feature offered is urid:map
+    ph->n_uris = 0;
+    ph->map.handle = ph;
+    ph->map.map = ph_map;
+    ph->map_feature.URI = LV2_URID__map;
+    ph->map_feature.data = &ph->map;
+    ph->features[0] = &ph->map_feature;
+    ph->features[1] = NULL;
+
+    ph->handle = ph->desc->instantiate(ph->desc, rate, "", ph->features);
+    if (!ph->handle) {
+        fprintf(stderr, "Cannot instantiate %s\n", path);
+        return 1;
+    }
+
+    ph_defaults(ph);
+    for (uint32_t p = 0 ; p < PH_N_PORTS ; ++p) {
+        switch (p) {
+            case PH_INPUT_L:
+                ph->desc->connect_port(ph->handle, p, ph->in_l);
+                break;
+            case PH_INPUT_R:
+                ph->desc->connect_port(ph->handle, p, ph->in_r);
+                break;
+            case PH_OUTPUT_L:
+                ph->desc->connect_port(ph->handle, p, ph->out_l);
+                break;
+            case PH_OUTPUT_R:
+                ph->desc->connect_port(ph->handle, p, ph->out_r);
+                break;
+            default:
+                ph->desc->connect_port(ph->handle, p, &ph->ctl[p]);
+                break;
+        }
+    }
+    ph->desc->activate(ph->handle);
+    return 0;
+}
+
+
+/**
+* Sets all control ports to the defaults of bolliedelay.ttl
+* \param ph Pointer to the PlugHost object
+*/
+void ph_defaults(PlugHost* ph) {
+    for (uint32_t p = 0 ; p < PH_N_PORTS ; ++p)
+        ph->ctl[p] = 0;
+
+    ph->ctl[PH_TEMPO_HOST] = 120;
+    ph->ctl[PH_TEMPO_USER] = 120;
+    ph->ctl[PH_MIX] = 30;
+    ph->ctl[PH_FEEDBACK] = 40;
+    ph->ctl[PH_CROSSF] = 20;
+    ph->ctl[PH_LOW_F] = 20;
+    ph->ctl[PH_LOW_Q] = 1;
+    ph->ctl[PH_HIGH_F] = 7500;
+    ph->ctl[PH_HIGH_Q] = 1;
+    ph->ctl[PH_TEMPO_OUT] = 120;
+}
+
+
+/**
+* Fills both input buffers with independent white noise.
+* \param ph        Pointer to the PlugHost object
+* \param n_samples Number of samples
+* \param seed      rand_r() seed
+*/
+void ph_noise(PlugHost* ph, uint32_t n_samples, unsigned int* seed) {
+    for (uint32_t i = 0 ; i < n_samples ; ++i) {
+        ph->in_l[i] = rand_r(seed) * (2.0f / RAND_MAX) - 1;
+        ph->in_r[i] = rand_r(seed) * (2.0f / RAND_MAX) - 1;
+    }
+}
+
+
+/**
+* Runs the plugin on the current input buffers.
+* \param ph        Pointer to the PlugHost object
+* \param n_samples Number of samples, must not exceed max_block
+*/
+void ph_run(PlugHost* ph, uint32_t n_samples) {
+    ph->desc->run(ph->handle, n_samples);
+}
+
+
+/**
+* Deactivates and frees the plugin instance.
+* \param ph Pointer to the PlugHost object
+*/
+void ph_close(PlugHost* ph) {
+    ph->desc->deactivate(ph->handle);
+    ph->desc->cleanup(ph->handle);
+    free(ph->in_l);
+    free(ph->in_r);
+    free(ph->out_l);
+    free(ph->out_r);
+    for (uint32_t i = 0 ; i < ph->n_uris ; ++i)
+        free(ph->uris[i]);
+    dlclose(ph->lib);
+}
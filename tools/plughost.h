@@ -0,0 +1,93 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file plughost.h
+* \author Bollie
+* \date 19 Oct 2026
+* \brief A minimal LV2 host for driving the plugin from the tools.
+*/
+
+#ifndef __PLUGHOST_H__
+#define __PLUGHOST_H__
+
+#include <stdint.h>
+#include "lv2/lv2plug.in/ns/lv2core/lv2.h"
+#include "lv2/lv2plug.in/ns/ext/urid/urid.h"
+
+#define PH_MAX_URIS 64      ///< URIs the URID map can hold
+
+/**
+* Port indices, have to match bolliedelay.ttl
+*/
+typedef enum {
+    PH_TEMPO_HOST  = 0,
+    PH_TEMPO_USER  = 1,
+    PH_TEMPO_MODE  = 2,
+    PH_TAP         = 3,
+    PH_MIX         = 4,
+    PH_FEEDBACK    = 5,
+    PH_CROSSF      = 6,
+    PH_LOW_ON      = 7,
+    PH_LOW_F       = 8,
+    PH_LOW_Q       = 9,
+    PH_HIGH_ON     = 10,
+    PH_HIGH_F      = 11,
+    PH_HIGH_Q      = 12,
+    PH_DIV_L       = 13,
+    PH_DIV_R       = 14,
+    PH_INPUT_L     = 15,
+    PH_INPUT_R     = 16,
+    PH_OUTPUT_L    = 17,
+    PH_OUTPUT_R    = 18,
+    PH_TEMPO_OUT   = 19,
+    PH_QUALITY     = 20,
+    PH_FREEZE      = 21,
+    PH_N_PORTS
+} PlugHostPort;
+
+
+/**
+* Host state for one plugin instance
+*/
+typedef struct {
+    void* lib;                      ///< dlopen() handle
+    const LV2_Descriptor* desc;     ///< plugin descriptor
+    LV2_Handle handle;              ///< plugin instance
+    double rate;                    ///< sample rate
+    uint32_t max_block;             ///< size of the audio buffers
+    float ctl[PH_N_PORTS];          ///< control port values
+    float* in_l;                    ///< input buffer, left
+    float* in_r;                    ///< input buffer, right
+    float* out_l;                   ///< output buffer, left
+    float* out_r;                   ///< output buffer, right
+    char* uris[PH_MAX_URIS];        ///< mapped URIs, the URID is index + 1
+    uint32_t n_uris;                ///< number of mapped URIs
+    LV2_URID_Map map;               ///< URID map feature data
+    LV2_Feature map_feature;        ///< URID map feature
+    const LV2_Feature* features[2]; ///< features passed to instantiate()
+} PlugHost;
+
+int ph_open(PlugHost* ph, const char* path, double rate, uint32_t max_block);
+void ph_defaults(PlugHost* ph);
+void ph_noise(PlugHost* ph, uint32_t n_samples, unsigned int* seed);
+void ph_run(PlugHost* ph, uint32_t n_samples);
+void ph_close(PlugHost* ph);
+
+#endif
@@ -0,0 +1,536 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file rtcheck-shim.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief LD_PRELOAD shim reporting calls, that are not realtime safe.
+*
+* The driver (rtcheck.c) brackets every run() call with rtcheck_enter() and
+* rtcheck_leave(). Any of the functions below called in between gets
+* reported along with a backtrace. The plugin binary is stripped unless it
+* is built with DEBUG=true, so use that for readable backtraces.
+*
+* glibc calls its own syscalls internally, e.g. stdio never goes through
+* write() or open() below. That is why the stdio entry points are wrapped
+* as well.
+*/
+
+#define _GNU_SOURCE
+// The fortified inlines would replace some of the wrappers below
+#undef _FORTIFY_SOURCE
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#define RTC_EXPORT __attribute__((visibility("default")))
+#define RTC_MAX_FRAMES 32
+
+// glibc's internal allocator entry points, these never recurse into us
+extern void* __libc_malloc(size_t);
+extern void* __libc_calloc(size_t, size_t);
+extern void* __libc_realloc(void*, size_t);
+extern void  __libc_free(void*);
+extern void* __libc_memalign(size_t, size_t);
+
+static __thread int depth = 0;      ///< > 0 while inside run()
+static __thread int reporting = 0;  ///< guards against recursive reports
+static int violations = 0;          ///< number of forbidden calls seen
+
+static int (*real_mutex_lock)(pthread_mutex_t*);
+static int (*real_mutex_trylock)(pthread_mutex_t*);
+static int (*real_mutex_unlock)(pthread_mutex_t*);
+static int (*real_mutex_timedlock)(pthread_mutex_t*, const struct timespec*);
+static int (*real_cond_wait)(pthread_cond_t*, pthread_mutex_t*);
+static int (*real_cond_timedwait)(pthread_cond_t*, pthread_mutex_t*,
+    const struct timespec*);
+static int (*real_rwlock_rdlock)(pthread_rwlock_t*);
+static int (*real_rwlock_tryrdlock)(pthread_rwlock_t*);
+static int (*real_rwlock_timedrdlock)(pthread_rwlock_t*,
+    const struct timespec*);
+static int (*real_rwlock_wrlock)(pthread_rwlock_t*);
+static int (*real_rwlock_trywrlock)(pthread_rwlock_t*);
+static int (*real_rwlock_timedwrlock)(pthread_rwlock_t*,
+    const struct timespec*);
+static int (*real_rwlock_unlock)(pthread_rwlock_t*);
+static int (*real_sem_wait)(sem_t*);
+static int (*real_sem_timedwait)(sem_t*, const struct timespec*);
+static ssize_t (*real_read)(int, void*, size_t);
+static ssize_t (*real_write)(int, const void*, size_t);
+static int (*real_open)(const char*, int, ...);
+static int (*real_open64)(const char*, int, ...);
+static int (*real_openat)(int, const char*, int, ...);
+static int (*real_openat64)(int, const char*, int, ...);
+static int (*real_close)(int);
+static void* (*real_mmap)(void*, size_t, int, int, int, off_t);
+static int (*real_munmap)(void*, size_t);
+static int (*real_nanosleep)(const struct timespec*, struct timespec*);
+static int (*real_clock_nanosleep)(clockid_t, int, const struct timespec*,
+    struct timespec*);
+static int (*real_usleep)(useconds_t);
+static int (*real_sched_yield)(void);
+static int (*real_gettimeofday)(struct timeval*, void*);
+static long (*real_syscall)(long, ...);
+static int (*real_vfprintf)(FILE*, const char*, va_list);
+static int (*real_fputs)(const char*, FILE*);
+static int (*real_fputc)(int, FILE*);
+static size_t (*real_fwrite)(const void*, size_t, size_t, FILE*);
+static int (*real_fflush)(FILE*);
+static FILE* (*real_fopen)(const char*, const char*);
+static FILE* (*real_fopen64)(const char*, const char*);
+static int (*real_fclose)(FILE*);
+
+
+/**
+* Resolves the real functions and preloads libgcc for backtrace(), as its
+* first call allocates.
+*/
+__attribute__((constructor)) static void rtc_init() {
+    void* frames[1];
+    backtrace(frames, 1);
+
+    real_mutex_lock = dlsym(RTLD_NEXT, "pthread_mutex_lock");
+    real_mutex_trylock = dlsym(RTLD_NEXT, "pthread_mutex_trylock");
+    real_mutex_unlock = dlsym(RTLD_NEXT, "pthread_mutex_unlock");
+    real_mutex_timedlock = dlsym(RTLD_NEXT, "pthread_mutex_timedlock");
+    real_cond_wait = dlsym(RTLD_NEXT, "pthread_cond_wait");
+    real_cond_timedwait = dlsym(RTLD_NEXT, "pthread_cond_timedwait");
+    real_rwlock_rdlock = dlsym(RTLD_NEXT, "pthread_rwlock_rdlock");
+    real_rwlock_tryrdlock = dlsym(RTLD_NEXT, "pthread_rwlock_tryrdlock");
+    real_rwlock_timedrdlock = dlsym(RTLD_NEXT, "pthread_rwlock_timedrdlock");
+    real_rwlock_wrlock = dlsym(RTLD_NEXT, "pthread_rwlock_wrlock");
+    real_rwlock_trywrlock = dlsym(RTLD_NEXT, "pthread_rwlock_trywrlock");
+    real_rwlock_timedwrlock = dlsym(RTLD_NEXT, "pthread_rwlock_timedwrlock");
+    real_rwlock_unlock = dlsym(RTLD_NEXT, "pthread_rwlock_unlock");
+    real_sem_wait = dlsym(RTLD_NEXT, "sem_wait");
+    real_sem_timedwait = dlsym(RTLD_NEXT, "sem_timedwait");
+    real_read = dlsym(RTLD_NEXT, "read");
+    real_write = dlsym(RTLD_NEXT, "write");
+    real_open = dlsym(RTLD_NEXT, "open");
+    real_open64 = dlsym(RTLD_NEXT, "open64");
+    real_openat = dlsym(RTLD_NEXT, "openat");
+    real_openat64 = dlsym(RTLD_NEXT, "openat64");
+    real_close = dlsym(RTLD_NEXT, "close");
+    real_mmap = dlsym(RTLD_NEXT, "mmap");
+    real_munmap = dlsym(RTLD_NEXT, "munmap");
+    real_nanosleep = dlsym(RTLD_NEXT, "nanosleep");
+    real_clock_nanosleep = dlsym(RTLD_NEXT, "clock_nanosleep");
+    real_usleep = dlsym(RTLD_NEXT, "usleep");
+    real_sched_yield = dlsym(RTLD_NEXT, "sched_yield");
+    real_gettimeofday = dlsym(RTLD_NEXT, "gettimeofday");
+    real_syscall = dlsym(RTLD_NEXT, "syscall");
+    real_vfprintf = dlsym(RTLD_NEXT, "vfprintf");
+    real_fputs = dlsym(RTLD_NEXT, "fputs");
+    real_fputc = dlsym(RTLD_NEXT, "fputc");
+    real_fwrite = dlsym(RTLD_NEXT, "fwrite");
+    real_fflush = dlsym(RTLD_NEXT, "fflush");
+    real_fopen = dlsym(RTLD_NEXT, "fopen");
+    real_fopen64 = dlsym(RTLD_NEXT, "fopen64");
+    real_fclose = dlsym(RTLD_NEXT, "fclose");
+}
+
+
+/**
+* Reports a forbidden call, if we are inside run().
+* \param name name of the intercepted function
+*/
+static void violation(const char* name) {
+    if (depth <= 0 || reporting)
+        return;
+
+    reporting = 1;
+    violations++;
+
+    void* frames[RTC_MAX_FRAMES];
+    int n = backtrace(frames, RTC_MAX_FRAMES);
+    char msg[128];
+    int len = snprintf(msg, sizeof(msg),
+        "rtcheck: %s() called inside run()\n", name);
+    real_write(2, msg, len);
+    backtrace_symbols_fd(frames + 1, n - 1, 2);
+    real_write(2, "\n", 1);
+
+    reporting = 0;
+}
+
+
+/**
+* Marks the start of a run() call.
+*/
+RTC_EXPORT void rtcheck_enter() {
+    depth++;
+}
+
+
+/**
+* Marks the end of a run() call.
+*/
+RTC_EXPORT void rtcheck_leave() {
+    depth--;
+}
+
+
+/**
+* \return number of forbidden calls seen so far
+*/
+RTC_EXPORT int rtcheck_violations() {
+    return violations;
+}
+
+
+/* Memory allocation */
+
+RTC_EXPORT void* malloc(size_t size) {
+    violation("malloc");
+    return __libc_malloc(size);
+}
+
+RTC_EXPORT void* calloc(size_t n, size_t size) {
+    violation("calloc");
+    return __libc_calloc(n, size);
+}
+
+RTC_EXPORT void* realloc(void* ptr, size_t size) {
+    violation("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+RTC_EXPORT void free(void* ptr) {
+    violation("free");
+    __libc_free(ptr);
+}
+
+RTC_EXPORT void* memalign(size_t align, size_t size) {
+    violation("memalign");
+    return __libc_memalign(align, size);
+}
+
+RTC_EXPORT void* aligned_alloc(size_t align, size_t size) {
+    violation("aligned_alloc");
+    return __libc_memalign(align, size);
+}
+
+RTC_EXPORT int posix_memalign(void** ptr, size_t align, size_t size) {
+    violation("posix_memalign");
+    *ptr = __libc_memalign(align, size);
+    return *ptr ? 0 : 12;
+}
+
+
+/* Locking */
+
+RTC_EXPORT int pthread_mutex_lock(pthread_mutex_t* m) {
+    violation("pthread_mutex_lock");
+    return real_mutex_lock(m);
+}
+
+RTC_EXPORT int pthread_mutex_trylock(pthread_mutex_t* m) {
+    violation("pthread_mutex_trylock");
+    return real_mutex_trylock(m);
+}
+
+RTC_EXPORT int pthread_mutex_unlock(pthread_mutex_t* m) {
+    violation("pthread_mutex_unlock");
+    return real_mutex_unlock(m);
+}
+
+RTC_EXPORT int pthread_mutex_timedlock(pthread_mutex_t* m,
+    const struct timespec* t) {
+    violation("pthread_mutex_timedlock");
+    return real_mutex_timedlock(m, t);
+}
+
+RTC_EXPORT int pthread_cond_wait(pthread_cond_t* c, pthread_mutex_t* m) {
+    violation("pthread_cond_wait");
+    return real_cond_wait(c, m);
+}
+
+RTC_EXPORT int pthread_cond_timedwait(pthread_cond_t* c, pthread_mutex_t* m,
+    const struct timespec* t) {
+    violation("pthread_cond_timedwait");
+    return real_cond_timedwait(c, m, t);
+}
+
+RTC_EXPORT int pthread_rwlock_rdlock(pthread_rwlock_t* l) {
+    violation("pthread_rwlock_rdlock");
+    return real_rwlock_rdlock(l);
+}
+
+RTC_EXPORT int pthread_rwlock_tryrdlock(pthread_rwlock_t* l) {
+    violation("pthread_rwlock_tryrdlock");
+    return real_rwlock_tryrdlock(l);
+}
+
+RTC_EXPORT int pthread_rwlock_timedrdlock(pthread_rwlock_t* l,
+    const struct timespec* t) {
+    violation("pthread_rwlock_timedrdlock");
+    return real_rwlock_timedrdlock(l, t);
+}
+
+RTC_EXPORT int pthread_rwlock_wrlock(pthread_rwlock_t* l) {
+    violation("pthread_rwlock_wrlock");
+    return real_rwlock_wrlock(l);
+}
+
+RTC_EXPORT int pthread_rwlock_trywrlock(pthread_rwlock_t* l) {
+    violation("pthread_rwlock_trywrlock");
+    return real_rwlock_trywrlock(l);
+}
+
+RTC_EXPORT int pthread_rwlock_timedwrlock(pthread_rwlock_t* l,
+    const struct timespec* t) {
+    violation("pthread_rwlock_timedwrlock");
+    return real_rwlock_timedwrlock(l, t);
+}
+
+RTC_EXPORT int pthread_rwlock_unlock(pthread_rwlock_t* l) {
+    violation("pthread_rwlock_unlock");
+    return real_rwlock_unlock(l);
+}
+
+RTC_EXPORT int sem_wait(sem_t* sem) {
+    violation("sem_wait");
+    return real_sem_wait(sem);
+}
+
+RTC_EXPORT int sem_timedwait(sem_t* sem, const struct timespec* t) {
+    violation("sem_timedwait");
+    return real_sem_timedwait(sem, t);
+}
+
+
+/* System calls */
+
+RTC_EXPORT ssize_t read(int fd, void* buf, size_t n) {
+    violation("read");
+    return real_read(fd, buf, n);
+}
+
+RTC_EXPORT ssize_t write(int fd, const void* buf, size_t n) {
+    violation("write");
+    return real_write(fd, buf, n);
+}
+
+RTC_EXPORT int open(const char* path, int flags, ...) {
+    violation("open");
+    va_list ap;
+    va_start(ap, flags);
+    int mode = va_arg(ap, int);
+    va_end(ap);
+    return real_open(path, flags, mode);
+}
+
+RTC_EXPORT int open64(const char* path, int flags, ...) {
+    violation("open64");
+    va_list ap;
+    va_start(ap, flags);
+    int mode = va_arg(ap, int);
+    va_end(ap);
+    return real_open64(path, flags, mode);
+}
+
+RTC_EXPORT int openat(int dir, const char* path, int flags, ...) {
+    violation("openat");
+    va_list ap;
+    va_start(ap, flags);
+    int mode = va_arg(ap, int);
+    va_end(ap);
+    return real_openat(dir, path, flags, mode);
+}
+
+RTC_EXPORT int openat64(int dir, const char* path, int flags, ...) {
+    violation("openat64");
+    va_list ap;
+    va_start(ap, flags);
+    int mode = va_arg(ap, int);
+    va_end(ap);
+    return real_openat64(dir, path, flags, mode);
+}
+
+RTC_EXPORT int close(int fd) {
+    violation("close");
+    return real_close(fd);
+}
+
+RTC_EXPORT void* mmap(void* addr, size_t len, int prot, int flags, int fd,
+    off_t off) {
+    violation("mmap");
+    return real_mmap(addr, len, prot, flags, fd, off);
+}
+
+RTC_EXPORT int munmap(void* addr, size_t len) {
+    violation("munmap");
+    return real_munmap(addr, len);
+}
+
+RTC_EXPORT int nanosleep(const struct timespec* req, struct timespec* rem) {
+    violation("nanosleep");
+    return real_nanosleep(req, rem);
+}
+
+RTC_EXPORT int clock_nanosleep(clockid_t clock, int flags,
+    const struct timespec* req, struct timespec* rem) {
+    violation("clock_nanosleep");
+    return real_clock_nanosleep(clock, flags, req, rem);
+}
+
+RTC_EXPORT int usleep(useconds_t usec) {
+    violation("usleep");
+    return real_usleep(usec);
+}
+
+RTC_EXPORT int sched_yield(void) {
+    violation("sched_yield");
+    return real_sched_yield();
+}
+
+RTC_EXPORT int gettimeofday(struct timeval* tv, void* tz) {
+    violation("gettimeofday");
+    return real_gettimeofday(tv, tz);
+}
+
+RTC_EXPORT long syscall(long nr, ...) {
+    violation("syscall");
+    va_list ap;
+    va_start(ap, nr);
+    long a[6];
+    for (int i = 0 ; i < 6 ; ++i)
+        a[i] = va_arg(ap, long);
+    va_end(ap);
+    return real_syscall(nr, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+
+/* stdio, the compiler turns printf() into puts() and the like, with
+   _FORTIFY_SOURCE into the __*_chk variants */
+
+RTC_EXPORT int vfprintf(FILE* f, const char* fmt, va_list ap) {
+    violation("vfprintf");
+    return real_vfprintf(f, fmt, ap);
+}
+
+RTC_EXPORT int vprintf(const char* fmt, va_list ap) {
+    violation("vprintf");
+    return real_vfprintf(stdout, fmt, ap);
+}
+
+RTC_EXPORT int fprintf(FILE* f, const char* fmt, ...) {
+    violation("fprintf");
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = real_vfprintf(f, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+RTC_EXPORT int printf(const char* fmt, ...) {
+    violation("printf");
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = real_vfprintf(stdout, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+RTC_EXPORT int __vfprintf_chk(FILE* f, int flag, const char* fmt,
+    va_list ap) {
+    violation("__vfprintf_chk");
+    return real_vfprintf(f, fmt, ap);
+}
+
+RTC_EXPORT int __fprintf_chk(FILE* f, int flag, const char* fmt, ...) {
+    violation("__fprintf_chk");
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = real_vfprintf(f, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+RTC_EXPORT int __printf_chk(int flag, const char* fmt, ...) {
+    violation("__printf_chk");
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = real_vfprintf(stdout, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+RTC_EXPORT int puts(const char* s) {
+    violation("puts");
+    if (real_fputs(s, stdout) < 0)
+        return EOF;
+    return real_fputc('\n', stdout);
+}
+
+RTC_EXPORT int fputs(const char* s, FILE* f) {
+    violation("fputs");
+    return real_fputs(s, f);
+}
+
+RTC_EXPORT int fputc(int c, FILE* f) {
+    violation("fputc");
+    return real_fputc(c, f);
+}
+
+RTC_EXPORT int putc(int c, FILE* f) {
+    violation("putc");
+    return real_fputc(c, f);
+}
+
+RTC_EXPORT int putchar(int c) {
+    violation("putchar");
+    return real_fputc(c, stdout);
+}
+
+RTC_EXPORT size_t fwrite(const void* ptr, size_t size, size_t n, FILE* f) {
+    violation("fwrite");
+    return real_fwrite(ptr, size, n, f);
+}
+
+RTC_EXPORT int fflush(FILE* f) {
+    violation("fflush");
+    return real_fflush(f);
+}
+
+RTC_EXPORT FILE* fopen(const char* path, const char* mode) {
+    violation("fopen");
+    return real_fopen(path, mode);
+}
+
+RTC_EXPORT FILE* fopen64(const char* path, const char* mode) {
+    violation("fopen64");
+    return real_fopen64(path, mode);
+}
+
+RTC_EXPORT int fclose(FILE* f) {
+    violation("fclose");
+    return real_fclose(f);
+}
@@ -0,0 +1,197 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file rtcheck.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief Drives run() under parameter scripts with rtcheck-shim preloaded.
+*
+* Usage: LD_PRELOAD=rtcheck-shim.so rtcheck [plugin binary]
+* Exits non-zero, if any call inside run() was not realtime safe.
+*/
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "plughost.h"
+
+#define MAX_BLOCK 1024
+#define RATE 48000
+
+
+/**
+* A parameter script, called before every block. The input buffers are
+* already filled with noise at that point.
+*/
+typedef struct {
+    const char* name;                       ///< printed in the report
+    void (*step)(PlugHost* ph, uint32_t b); ///< sets the ports for block b
+} Script;
+
+
+static void script_defaults(PlugHost* ph, uint32_t b) {
+}
+
+static void script_tempo(PlugHost* ph, uint32_t b) {
+    ph->ctl[PH_TEMPO_MODE] = 1;
+    ph->ctl[PH_TEMPO_USER] = 6 + (b * 7) % 995;
+}
+
+static void script_tap(PlugHost* ph, uint32_t b) {
+    ph->ctl[PH_TEMPO_MODE] = 2;
+    ph->ctl[PH_TAP] = (b % 20 == 0);
+}
+
+static void script_divisions(PlugHost* ph, uint32_t b) {
+    ph->ctl[PH_DIV_L] = (b / 50) % 6;
+    ph->ctl[PH_DIV_R] = (b / 70) % 6;
+}
+
+static void script_filters(PlugHost* ph, uint32_t b) {
+    ph->ctl[PH_LOW_ON] = (b / 30) % 2;
+    ph->ctl[PH_HIGH_ON] = (b / 45) % 2;
+    ph->ctl[PH_LOW_F] = 20 + (b * 13) % 1980;
+    ph->ctl[PH_LOW_Q] = 0.125f + (b % 64) * 0.125f;
+    ph->ctl[PH_HIGH_F] = 200 + (b * 97) % 21800;
+    ph->ctl[PH_HIGH_Q] = 0.125f + ((b + 32) % 64) * 0.125f;
+}
+
+static void script_gains(PlugHost* ph, uint32_t b) {
+    static const float v[] = { 0, 1, 25, 49.5, 50, 50.5, 75, 99, 100 };
+    ph->ctl[PH_MIX] = v[b % 9];
+    ph->ctl[PH_FEEDBACK] = v[(b / 3) % 9];
+    ph->ctl[PH_CROSSF] = v[(b / 9) % 9];
+}
+
+static void script_quality(PlugHost* ph, uint32_t b) {
+    ph->ctl[PH_QUALITY] = (b / 40) % 3;
+    ph->ctl[PH_TEMPO_MODE] = 1;
+    ph->ctl[PH_TEMPO_USER] = (b / 100) % 2 ? 90 : 150;
+}
+
+static void script_mono(PlugHost* ph, uint32_t b) {
+    // Alternates between identical and independent inputs
+    if ((b / 300) % 2 == 0)
+        memcpy(ph->in_r, ph->in_l, ph->max_block * sizeof(float));
+    ph->ctl[PH_QUALITY] = (b / 600) % 3;
+    ph->ctl[PH_TEMPO_MODE] = 1;
+    ph->ctl[PH_TEMPO_USER] = 600;
+    ph->ctl[PH_FEEDBACK] = 30;
+    ph->ctl[PH_CROSSF] = 25;
+}
+
+static void script_freeze(PlugHost* ph, uint32_t b) {
+    // Tempo and quality changes while frozen only apply afterwards
+    if ((b / 500) % 2 == 0)
+        memcpy(ph->in_r, ph->in_l, ph->max_block * sizeof(float));
+    ph->ctl[PH_FREEZE] = (b / 70) % 2;
+    ph->ctl[PH_QUALITY] = (b / 300) % 3;
+    ph->ctl[PH_TEMPO_MODE] = 1;
+    ph->ctl[PH_TEMPO_USER] = (b / 110) % 2 ? 400 : 600;
+    ph->ctl[PH_LOW_ON] = 1;
+    ph->ctl[PH_HIGH_ON] = 1;
+}
+
+static void script_random(PlugHost* ph, uint32_t b) {
+    static unsigned int seed = 42;
+    PlugHostPort p = rand_r(&seed) % PH_N_PORTS;
+    switch (p) {
+        case PH_INPUT_L:
+        case PH_INPUT_R:
+        case PH_OUTPUT_L:
+        case PH_OUTPUT_R:
+        case PH_TEMPO_OUT:
+            break;
+        case PH_TEMPO_MODE:
+        case PH_QUALITY:
+            ph->ctl[p] = rand_r(&seed) % 3;
+            break;
+        case PH_FREEZE:
+            ph->ctl[p] = rand_r(&seed) % 2;
+            break;
+        case PH_DIV_L:
+        case PH_DIV_R:
+            ph->ctl[p] = rand_r(&seed) % 6;
+            break;
+        case PH_TEMPO_HOST:
+        case PH_TEMPO_USER:
+            ph->ctl[p] = 6 + rand_r(&seed) % 995;
+            break;
+        default:
+            ph->ctl[p] = rand_r(&seed) % 101;
+            break;
+    }
+}
+
+static const Script scripts[] = {
+    { "defaults",   script_defaults },
+    { "tempo",      script_tempo },
+    { "tap",        script_tap },
+    { "divisions",  script_divisions },
+    { "filters",    script_filters },
+    { "gains",      script_gains },
+    { "quality",    script_quality },
+    { "mono",       script_mono },
+    { "freeze",     script_freeze },
+    { "random",     script_random },
+};
+
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "build/bolliedelay.lv2/bolliedelay.so";
+
+    void (*enter)() = (void (*)())dlsym(RTLD_DEFAULT, "rtcheck_enter");
+    void (*leave)() = (void (*)())dlsym(RTLD_DEFAULT, "rtcheck_leave");
+    int (*violations)() = (int (*)())dlsym(RTLD_DEFAULT, "rtcheck_violations");
+    if (!enter || !leave || !violations) {
+        fprintf(stderr, "rtcheck-shim is not preloaded, use LD_PRELOAD\n");
+        return 2;
+    }
+
+    int failed = 0;
+    for (unsigned int s = 0 ; s < sizeof(scripts) / sizeof(scripts[0]) ; ++s) {
+        PlugHost ph;
+        unsigned int seed = s + 1;
+        if (ph_open(&ph, path, RATE, MAX_BLOCK))
+            return 2;
+
+        int before = violations();
+        for (uint32_t b = 0 ; b < 2000 ; ++b) {
+            uint32_t n = 1 + (b * 211) % MAX_BLOCK;
+            ph_noise(&ph, ph.max_block, &seed);
+            scripts[s].step(&ph, b);
+
+            enter();
+            ph_run(&ph, n);
+            leave();
+        }
+        ph_close(&ph);
+
+        int found = violations() - before;
+        printf("%-12s %s", scripts[s].name, found ? "FAIL" : "ok");
+        if (found)
+            printf(" (%d forbidden calls)", found);
+        printf("\n");
+        failed |= found;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,315 @@
+/**
+    Bollie Delay - (c) 2016 Thomas Ebeling https://ca9.eu
+
+    This file is part of bolliedelay.lv2
+
+    bolliedelay.lv2 is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    bolliedelay.lv2 is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* \file statecheck.c
+* \author Bollie
+* \date 19 Oct 2026
+* \brief Saves and restores the plugin's state through the LV2 state
+* interface.
+*
+* Usage: statecheck [plugin binary]
+*
+* roundtrip restores the state of a running instance into a second one,
+* which then has to play the same repeats, at every tape rate. rejected
+* restores states, that can't bring back the tape (another sample rate or
+* saved before the tape was cycling). Only the tapped tempo may come back,
+* after activate() the tape has to be empty. Exits non-zero, if any check
+* fails.
+*/
+
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "lv2/lv2plug.in/ns/ext/state/state.h"
+#include "plughost.h"
+
+#define BLOCK 480
+#define RATE 48000
+#define MAX_ENTRIES 16
+#define MAX_DIFF 1e-4f      ///< Allowed difference of the restored repeats
+
+
+/**
+* A value stored by the plugin
+*/
+typedef struct {
+    uint32_t key;
+    void* value;
+    size_t size;
+    uint32_t type;
+} Entry;
+
+
+/**
+* A saved state, the tape snapshot goes to dir
+*/
+typedef struct {
+    Entry entries[MAX_ENTRIES];
+    int n;
+    char dir[32];
+} State;
+
+
+static LV2_State_Status store(LV2_State_Handle handle, uint32_t key,
+    const void* value, size_t size, uint32_t type, uint32_t flags) {
+
+    State* st = (State*)handle;
+    if (st->n == MAX_ENTRIES)
+        return LV2_STATE_ERR_UNKNOWN;
+    Entry* e = &st->entries[st->n++];
+    e->key = key;
+    e->value = malloc(size);
+    memcpy(e->value, value, size);
+    e->size = size;
+    e->type = type;
+    return LV2_STATE_SUCCESS;
+}
+
+static const void* retrieve(LV2_State_Handle handle, uint32_t key,
+    size_t* size, uint32_t* type, uint32_t* flags) {
+
+    State* st = (State*)handle;
+    for (int i = st->n - 1 ; i >= 0 ; --i) {
+        if (st->entries[i].key == key) {
+            *size = st->entries[i].size;
+            *type = st->entries[i].type;
+            *flags = LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE;
+            return st->entries[i].value;
+        }
+    }
+    return NULL;
+}
+
+static char* make_path(LV2_State_Make_Path_Handle handle, const char* path) {
+    State* st = (State*)handle;
+    char* abs_path;
+    if (asprintf(&abs_path, "%s/%s", st->dir, path) < 0)
+        return NULL;
+    return abs_path;
+}
+
+// Paths are stored as they are
+static char* map_path(LV2_State_Map_Path_Handle handle, const char* path) {
+    return strdup(path);
+}
+
+static void free_path(LV2_State_Free_Path_Handle handle, char* path) {
+    free(path);
+}
+
+
+/**
+* Saves or restores the state of an instance.
+* \param ph   instance
+* \param st   state to save into or restore from
+* \param save 1 to save, 0 to restore
+* \return LV2_STATE_SUCCESS or an error
+*/
+static LV2_State_Status state(PlugHost* ph, State* st, int save) {
+    const LV2_State_Interface* iface =
+        ph->desc->extension_data(LV2_STATE__interface);
+    if (!iface)
+        return LV2_STATE_ERR_NO_FEATURE;
+
+    LV2_State_Make_Path mk = { st, make_path };
+    LV2_State_Map_Path mp = { st, map_path, map_path };
+    LV2_State_Free_Path fp = { st, free_path };
+    const LV2_Feature f_mk = { LV2_STATE__makePath, &mk };
+    const LV2_Feature f_mp = { LV2_STATE__mapPath, &mp };
+    const LV2_Feature f_fp = { LV2_STATE__freePath, &fp };
+    const LV2_Feature* features[] = { &f_mk, &f_mp, &f_fp, NULL };
+
+    if (save)
+        return iface->save(ph->handle, store, st, 0, features);
+    return iface->restore(ph->handle, retrieve, st, 0, features);
+}
+
+
+/**
+* Creates an empty state with a directory for the tape snapshot.
+* \return 0 on success
+*/
+static int state_init(State* st) {
+    st->n = 0;
+    strcpy(st->dir, "/tmp/statecheck.XXXXXX");
+    return mkdtemp(st->dir) ? 0 : 1;
+}
+
+
+/**
+* Frees the values and removes the directory of a state.
+*/
+static void state_free(State* st) {
+    for (int i = 0 ; i < st->n ; ++i)
+        free(st->entries[i].value);
+    char* tape = make_path(st, "tape.raw");
+    unlink(tape);
+    free(tape);
+    rmdir(st->dir);
+}
+
+
+/**
+* Runs an instance on noise or silence.
+* \param ph      instance
+* \param blocks  number of blocks
+* \param seed    rand_r() seed for noise, NULL for silence
+*/
+static void run_blocks(PlugHost* ph, uint32_t blocks, unsigned int* seed) {
+    for (uint32_t b = 0 ; b < blocks ; ++b) {
+        if (seed)
+            ph_noise(ph, BLOCK, seed);
+        else
+            for (int i = 0 ; i < BLOCK ; ++i)
+                ph->in_l[i] = ph->in_r[i] = 0;
+        ph_run(ph, BLOCK);
+    }
+}
+
+
+/**
+* Sets the ports for check_roundtrip(): 120 BPM, 1/4 left and 1/4T right,
+* i.e. 0.5 s and 0.33 s, wet only.
+* \param ph      instance
+* \param quality tape rate
+*/
+static void roundtrip_ports(PlugHost* ph, int quality) {
+    ph->ctl[PH_TEMPO_MODE] = 1;
+    ph->ctl[PH_DIV_R] = 1;
+    ph->ctl[PH_MIX] = 100;
+    ph->ctl[PH_FEEDBACK] = 80;
+    ph->ctl[PH_QUALITY] = quality;
+}
+
+
+/**
+* Restores a running instance into a fresh one. Both play silence after
+* that, once the restored repeats have faded in they have to match until
+* the faded part comes round again.
+* \param path    plugin binary
+* \param quality tape rate
+* \return 0 if the repeats match
+*/
+static int check_roundtrip(const char* path, int quality) {
+    PlugHost a, b;
+    State st;
+    unsigned int seed = 1;
+    if (state_init(&st) || ph_open(&a, path, RATE, BLOCK) ||
+        ph_open(&b, path, RATE, BLOCK))
+        return 1;
+
+    roundtrip_ports(&a, quality);
+    roundtrip_ports(&b, quality);
+    run_blocks(&a, RATE * 2 / BLOCK, &seed);
+    int failed = (state(&a, &st, 1) != LV2_STATE_SUCCESS);
+    failed |= (state(&b, &st, 0) != LV2_STATE_SUCCESS);
+
+    float max_diff = 0;
+    float max_out = 0;
+    const uint32_t from = RATE / 10 / BLOCK;
+    const uint32_t to = RATE / 3 / BLOCK;
+    for (uint32_t n = 0 ; n < to ; ++n) {
+        run_blocks(&a, 1, NULL);
+        run_blocks(&b, 1, NULL);
+        for (int i = 0 ; n >= from && i < BLOCK ; ++i) {
+            max_diff = fmaxf(max_diff, fabsf(a.out_l[i] - b.out_l[i]));
+            max_diff = fmaxf(max_diff, fabsf(a.out_r[i] - b.out_r[i]));
+            max_out = fmaxf(max_out, fabsf(a.out_l[i]));
+        }
+    }
+    // Silence would match as well
+    failed |= (max_diff > MAX_DIFF || max_out < 0.1f);
+
+    printf("%-10s tape %-2d repeats %.3f, max. difference %.2g %s\n",
+        "roundtrip", quality, max_out, max_diff, failed ? "FAIL" : "ok");
+    ph_close(&a);
+    ph_close(&b);
+    state_free(&st);
+    return failed;
+}
+
+
+/**
+* Restores a state, that doesn't fit, into an instance with a filled tape.
+* Only the tapped tempo of 100 BPM may be restored, activate() then has to
+* clear the tape.
+* \param path      plugin binary
+* \param rate      sample rate of the restored instance
+* \param cycling   save while the tape is cycling
+* \return 0 if only the tapped tempo was restored
+*/
+static int check_rejected(const char* path, double rate, int cycling) {
+    PlugHost a, b;
+    State st;
+    unsigned int seed = 1;
+    if (state_init(&st) || ph_open(&a, path, RATE, BLOCK) ||
+        ph_open(&b, path, rate, BLOCK))
+        return 1;
+
+    // Two taps 0.6 s apart
+    a.ctl[PH_TEMPO_MODE] = 2;
+    for (int tap = 0 ; tap < 2 ; ++tap) {
+        a.ctl[PH_TAP] = 1;
+        run_blocks(&a, 1, &seed);
+        a.ctl[PH_TAP] = 0;
+        run_blocks(&a, (tap ? 0 : RATE * 6 / 10 / BLOCK - 1), &seed);
+    }
+    if (cycling)
+        run_blocks(&a, RATE * 2 / BLOCK, &seed);
+    int failed = (state(&a, &st, 1) != LV2_STATE_SUCCESS);
+
+    b.ctl[PH_TEMPO_MODE] = 2;
+    run_blocks(&b, rate * 2 / BLOCK, &seed);
+    failed |= (state(&b, &st, 0) != LV2_STATE_SUCCESS);
+    b.desc->activate(b.handle);
+
+    float max_out = 0;
+    for (uint32_t n = 0 ; n < rate * 2 / BLOCK ; ++n) {
+        run_blocks(&b, 1, NULL);
+        for (int i = 0 ; i < BLOCK ; ++i) {
+            max_out = fmaxf(max_out, fabsf(b.out_l[i]));
+            max_out = fmaxf(max_out, fabsf(b.out_r[i]));
+        }
+    }
+    failed |= (max_out != 0 || fabsf(b.ctl[PH_TEMPO_OUT] - 100) > 0.01f);
+
+    printf("%-10s %s at %gHz: tempo %.2f, output %.2g %s\n", "rejected",
+        cycling ? "cycling" : "filling", rate, b.ctl[PH_TEMPO_OUT], max_out,
+        failed ? "FAIL" : "ok");
+    ph_close(&a);
+    ph_close(&b);
+    state_free(&st);
+    return failed;
+}
+
+
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : "build/bolliedelay.lv2/bolliedelay.so";
+
+    int failed = 0;
+    for (int q = 0 ; q < 3 ; ++q)
+        failed |= check_roundtrip(path, q);
+    failed |= check_rejected(path, 44100, 1);
+    failed |= check_rejected(path, RATE, 0);
+    return failed ? 1 : 0;
+}